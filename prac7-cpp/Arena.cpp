@@ -0,0 +1,134 @@
+#include "Arena.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+/**
+ * Constructor for an Arena. No memory is reserved until the first allocation.
+ * @param initialBlockSize The size of the first block, doubled for each block after it
+ */
+Arena::Arena(size_t initialBlockSize) {
+    blocks = nullptr;
+    cursor = nullptr;
+    limit = nullptr;
+    nextBlockSize = initialBlockSize;
+    used = 0;
+    reserved = 0;
+    allocationCount = 0;
+    maxBytes = 0;
+}
+
+/**
+ * Releases every block, and with them everything allocated from this Arena
+ */
+Arena::~Arena() {
+    while (blocks != nullptr) {
+        Block* previous = blocks->previous;
+        free(blocks);
+        blocks = previous;
+    }
+}
+
+/**
+ * Slow path of bump(): start a new block large enough for the allocation
+ * @param bytes The size of the allocation
+ * @param alignment The alignment of the allocation
+ * @return The allocated memory
+ */
+void* Arena::grow(size_t bytes, size_t alignment) {
+    size_t needed = sizeof(Block) + bytes + alignment;
+    while (nextBlockSize < needed) {
+        nextBlockSize *= 2;
+    }
+
+    if (maxBytes != 0 && reserved + nextBlockSize > maxBytes) {
+        // a smaller block may still fit under the limit
+        if (reserved + needed > maxBytes) {
+            throw bad_alloc();
+        }
+        nextBlockSize = maxBytes - reserved;
+    }
+
+    Block* block = (Block*) malloc(nextBlockSize);
+    if (block == nullptr) {
+        throw bad_alloc();
+    }
+    block->previous = blocks;
+    block->size = nextBlockSize;
+    blocks = block;
+    reserved += nextBlockSize;
+
+    cursor = (char*) (block + 1);
+    limit = (char*) block + nextBlockSize;
+    if (nextBlockSize < (1 << 20)) {
+        nextBlockSize *= 2;
+    }
+    return bump(bytes, alignment);
+}
+
+/**
+ * Cap the memory this Arena may take from the system
+ * @param maxBytes The most bytes to reserve, 0 for no limit
+ * @throws std::bad_alloc from later allocations that would go past the limit
+ */
+void Arena::setLimit(size_t maxBytes) {
+    this->maxBytes = maxBytes;
+}
+
+/**
+ * Take over everything allocated from another Arena, which is left empty.
+ * What was allocated there is freed with this Arena instead. New allocations
+ * still go into this Arena's current block.
+ * @param other The Arena to empty, e.g. one that filled part of a tree on another thread
+ */
+void Arena::adopt(Arena& other) {
+    if (other.blocks == nullptr) {
+        return;
+    }
+    if (blocks == nullptr) {
+        blocks = other.blocks;
+    }
+    else {
+        // slip the other blocks in under the current one
+        Block* oldest = other.blocks;
+        while (oldest->previous != nullptr) {
+            oldest = oldest->previous;
+        }
+        oldest->previous = blocks->previous;
+        blocks->previous = other.blocks;
+    }
+    used += other.used;
+    reserved += other.reserved;
+    allocationCount += other.allocationCount;
+
+    other.blocks = nullptr;
+    other.cursor = nullptr;
+    other.limit = nullptr;
+    other.used = 0;
+    other.reserved = 0;
+    other.allocationCount = 0;
+}
+
+/**
+ * Allocation entry point for std::pmr containers
+ */
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+    return bump(bytes, alignment);
+}
+
+/**
+ * Memory is only given back when the Arena is destroyed
+ */
+void Arena::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    (void) pointer;
+    (void) bytes;
+    (void) alignment;
+}
+
+/**
+ * An Arena can only free memory it allocated itself
+ */
+bool Arena::do_is_equal(const memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,80 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+/**
+ * A bump-pointer allocator for objects that all die together.
+ * Allocating is a pointer increment, deallocating is a no-op, and every
+ * allocation is released at once when the Arena is destroyed.
+ * Destructors of objects placed in the Arena are never run, so they must
+ * not own memory from anywhere else.
+ */
+class Arena : public std::pmr::memory_resource {
+    private:
+        struct Block {
+            Block* previous;
+            size_t size;
+        };
+
+        Block* blocks;
+        char* cursor;
+        char* limit;
+        size_t nextBlockSize;
+
+        // accounting, see MemoryReport
+        size_t used;
+        size_t reserved;
+        size_t allocationCount;
+        size_t maxBytes;
+
+        void* grow(size_t bytes, size_t alignment);
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    public:
+        Arena(size_t initialBlockSize = 4096);
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* bump(size_t bytes, size_t alignment) {
+            char* start = (char*) (((size_t) cursor + alignment - 1) & ~(alignment - 1));
+            if (start + bytes > limit) {
+                return grow(bytes, alignment);
+            }
+            cursor = start + bytes;
+            used += bytes;
+            allocationCount++;
+            return start;
+        }
+
+        // bytes handed out, including child arrays that have since been outgrown
+        size_t bytesUsed() const { return used; }
+
+        // bytes taken from the system; the Arena never gives any back, so this is also its peak
+        size_t bytesReserved() const { return reserved; }
+
+        size_t allocations() const { return allocationCount; }
+
+        void setLimit(size_t maxBytes);
+
+        // the most bytes this Arena may reserve, 0 for no limit
+        size_t getLimit() const { return maxBytes; }
+
+        void adopt(Arena& other);
+
+        template <class T, class... Args>
+        T* make(Args&&... args) {
+            return new (bump(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+};
+
+#endif /*ARENA_H*/
@@ -0,0 +1,215 @@
+#ifndef BASICPARSER_H
+#define BASICPARSER_H
+
+#include <list>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "LineIndex.h"
+#include "ParseTree.h"
+#include "Profiler.h"
+#include "SymbolTable.h"
+#include "Token.h"
+#include "TokenBuffer.h"
+
+
+/**
+ * How the nesting productions (statements, expressions, terms) are parsed.
+ * Recursive uses recursive descent on the native stack. ExplicitStack keeps
+ * the nesting on a heap-allocated stack with a depth limit, so input of any
+ * nesting depth runs in bounded native stack space. Both build the same tree.
+ */
+enum class ParseMode {
+    Recursive,
+    ExplicitStack
+};
+
+/**
+ * A place where the input did not match the grammar, recorded in recovery mode
+ */
+struct ParseError {
+    size_t token;           // index of the unexpected token in the parser's input
+    NodeKind expectedKind;
+    Atom expected;          // Atoms::Empty when any token of expectedKind would do
+    const Token* found;
+
+    std::string message() const;
+
+    std::string describe(const LineIndex& lines) const;
+};
+
+/**
+ * The Jack parser, generic over what is done with what it parses.
+ *
+ * The compile methods do not build anything themselves. They tell a Sink
+ * about each production they start and finish and each token they accept,
+ * in source order, and the Sink decides what to make of it. A Sink is any
+ * class with these members, called without virtual dispatch:
+ *
+ *     void enter(NodeKind kind);                   a production starts
+ *     void token(Token* token);                    a token belongs to the innermost production
+ *     Token* makeToken(NodeKind kind, Atom value); a token that is not in the input, e.g. an error token
+ *     size_t mark();                               where the next child of the innermost production goes
+ *     void wrap(size_t mark, NodeKind kind);       a production starts around the children since mark
+ *     ParseTree* leave();                          the innermost production is finished
+ *
+ * leave() returns the finished node, which the compile methods return, or
+ * nullptr for a Sink that builds no tree. wrap() is needed because a
+ * binaryExpression is only known to be one after its left operand is parsed.
+ *
+ * TreeSink builds ParseTrees (see CompilerParser), ValidateSink only checks
+ * the grammar and allocates nothing, and CodeGenerator writes VM code.
+ * The member definitions are in BasicParser.tpp; each Sink's parser is
+ * explicitly instantiated once, next to the Sink.
+ */
+template <class Sink>
+class BasicParser {
+    public:
+
+        // only set when the parser was given its tokens to keep
+        std::unique_ptr<TokenBuffer> ownedTokens;
+
+        // the first token, the current token, and the end-of-input token the parser never moves past
+        Token* const* first;
+        Token* const* cursor;
+        Token* const* last;
+
+        // receives everything the compile methods parse
+        Sink sink;
+
+        ParseMode mode;
+        size_t maxDepth;
+
+        // in recovery mode, grammar errors are collected here instead of thrown
+        bool recovering;
+        std::vector<ParseError> errors;
+
+        // if set, filled with each declaration as it is parsed
+        SymbolTable* symbols;
+
+        // in lazy mode, subroutine bodies are left as placeholders, see setLazy()
+        bool lazy;
+
+        // set while compileClassParallel() finds the bodies, which it checks
+        // itself, so they are skipped even in recovery mode
+        bool prescanning;
+
+        // where the '{' of each placeholder not yet expanded is in the input
+        std::unordered_map<const ParseTree*, size_t> lazyBodies;
+
+
+        BasicParser(const TokenBuffer& tokens, Sink sink = Sink());
+        BasicParser(TokenBuffer&& tokens, Sink sink = Sink());
+        BasicParser(const std::list<Token*>& tokens, Sink sink = Sink());
+        BasicParser(Token* const* first, Token* const* last, Sink sink = Sink());
+
+        ParseTree* compileProgram();
+        ParseTree* compileClass();
+        ParseTree* compileClassVarDec();
+        ParseTree* compileSubroutine();
+        ParseTree* compileParameterList();
+        ParseTree* compileSubroutineBody();
+        ParseTree* compileVarDec();
+
+        ParseTree* compileStatements();
+        ParseTree* compileLet();
+        ParseTree* compileIf();
+        ParseTree* compileWhile();
+        ParseTree* compileDo();
+        ParseTree* compileReturn();
+
+        ParseTree* compileExpression();
+        ParseTree* compileBinary(int minPrecedence);
+        ParseTree* compileTerm();
+        ParseTree* compileExpressionList();
+
+        void setMode(ParseMode mode, size_t maxDepth = 1 << 20);
+
+        void setRecovery(bool recovering);
+
+        void setSymbols(SymbolTable* symbols);
+
+        void setLazy(bool lazy);
+
+        const std::vector<ParseError>& getErrors() const { return errors; }
+
+        void printCurrent();
+
+        void next();
+
+        // the current token, the end-of-input token once every token has been used
+        Token* current() { return *cursor; }
+
+        // true if the current token has the expected type and value
+        bool have(NodeKind expectedKind, Atom expectedValue) {
+            PROFILE_POINT(Have);
+            return (*cursor)->is(expectedKind, expectedValue);
+        }
+
+        Token* mustBe(NodeKind expectedKind, Atom expectedValue);
+
+        Token* fail(NodeKind expectedKind, Atom expectedValue = Atoms::Empty);
+
+    private:
+        // one pending production on the explicit stack, see ParseMode::ExplicitStack
+        struct Frame {
+            NodeKind kind;
+            int state;
+            size_t start;       // binaryExpression: mark() before the left operand
+            int minPrecedence;
+        };
+
+        // states of the frames used by iterateStatements() and iterateExpression()
+        enum FrameState {
+            START,
+            AFTER_BODY,      // if/while: statements of the body have been parsed
+            AFTER_ELSE,      // if: statements of the else branch have been parsed
+            AFTER_CHILD,     // expression/binaryExpression/expressionList: a child has been parsed
+            AFTER_OPERATOR,  // binaryExpression: the right operand of a wrapped operator has been parsed
+            AFTER_INDEX,     // term: the index of a[i] has been parsed
+            AFTER_ARGUMENTS, // term: the expressionList of a call has been parsed
+            AFTER_GROUP,     // term: the expression inside ( ) has been parsed
+            AFTER_OPERAND    // term: the operand of a unary operator has been parsed
+        };
+
+        // shorthands for the Sink events
+        void open(NodeKind kind) { sink.enter(kind); }
+        void add(Token* token) { sink.token(token); }
+        size_t mark() { return sink.mark(); }
+        void wrap(size_t start, NodeKind kind) { sink.wrap(start, kind); }
+        ParseTree* close() { return sink.leave(); }
+
+        // add the current token to the innermost production and advance past it
+        void take() {
+            sink.token(*cursor);
+            next();
+        }
+
+        // add a variable to the symbol table, if there is one
+        void declare(Atom name, Atom type, SymbolKind kind) {
+            if (symbols != nullptr) {
+                symbols->define(name, type, kind);
+            }
+        }
+
+        bool skipSubroutineBody();
+
+        bool endsStatements();
+        void skipToStatement();
+        void skipToClassMember();
+
+        ParseTree* iterateStatements();
+        ParseTree* iterateExpression(NodeKind start);
+        void push(std::vector<Frame>& stack, Frame frame);
+};
+
+class ParseException : public std::exception {
+    public:
+        const char* what();
+};
+
+#endif /*BASICPARSER_H*/
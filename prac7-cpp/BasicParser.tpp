@@ -0,0 +1,1325 @@
+#ifndef BASICPARSER_TPP
+#define BASICPARSER_TPP
+
+/*
+ * Member definitions of BasicParser. Only included where a parser is
+ * explicitly instantiated for a Sink, see BasicParser.h.
+ */
+
+#include <iostream>
+
+#include "BasicParser.h"
+
+namespace ParserGrammar {
+
+// values the simplified grammar matches that are not Jack keywords or symbols
+inline const Atom MAIN = Interner::global().intern("Main");
+inline const Atom SKIP = Interner::global().intern("skip");
+
+/**
+ * Binding power of each binary operator, indexed by the operator's atom,
+ * -1 for anything that is not a binary operator.
+ * Jack evaluates operators left to right with no priority, so all nine
+ * share one level; giving an operator a higher level makes it bind tighter.
+ */
+inline const struct OperatorTable {
+    int8_t precedence[Atoms::Count];
+
+    OperatorTable() {
+        for (Atom atom = 0; atom < Atoms::Count; atom++) {
+            precedence[atom] = -1;
+        }
+        for (Atom op : {Atoms::Plus, Atoms::Minus, Atoms::Star, Atoms::Slash, Atoms::Ampersand,
+                        Atoms::Pipe, Atoms::LessThan, Atoms::GreaterThan, Atoms::Equals}) {
+            precedence[op] = 1;
+        }
+    }
+} OPERATORS;
+
+/**
+ * Look up the current token in the operator table
+ * @return The token's binding power, or -1 if it is not a binary operator
+ */
+inline int binaryPrecedence(const Token* token) {
+    if(token->getKind() != NodeKind::Symbol || token->getAtom() >= Atoms::Count){
+        return -1;
+    }
+    return OPERATORS.precedence[token->getAtom()];
+}
+
+}
+
+/**
+ * Constructor for the BasicParser
+ * @param tokens The tokens to be parsed, borrowed. The buffer must outlive the
+ *               parser, and its tokens may become leaves of what the sink
+ *               builds, so they must outlive that too.
+ * @param sink Receives what is parsed
+ */
+template <class Sink>
+BasicParser<Sink>::BasicParser(const TokenBuffer& tokens, Sink sink) : sink(std::move(sink)) {
+    this->first = tokens.begin();
+    this->cursor = tokens.begin();
+    this->last = tokens.end();
+    this->mode = ParseMode::Recursive;
+    this->maxDepth = 1 << 20;
+    this->recovering = false;
+    this->symbols = nullptr;
+    this->lazy = false;
+    this->prescanning = false;
+}
+
+/**
+ * Constructor for the BasicParser
+ * @param tokens The tokens to be parsed, moved into the parser. What the sink
+ *               builds may use them as leaves, so the parser must outlive that.
+ * @param sink Receives what is parsed
+ */
+template <class Sink>
+BasicParser<Sink>::BasicParser(TokenBuffer&& tokens, Sink sink) : sink(std::move(sink)) {
+    this->ownedTokens = std::make_unique<TokenBuffer>(std::move(tokens));
+    this->first = ownedTokens->begin();
+    this->cursor = ownedTokens->begin();
+    this->last = ownedTokens->end();
+    this->mode = ParseMode::Recursive;
+    this->maxDepth = 1 << 20;
+    this->recovering = false;
+    this->symbols = nullptr;
+    this->lazy = false;
+    this->prescanning = false;
+}
+
+/**
+ * Constructor for the BasicParser
+ * @param tokens A linked list of tokens to be parsed. The tokens are borrowed
+ *               and may become leaves of what the sink builds, so they must
+ *               outlive that.
+ * @param sink Receives what is parsed
+ */
+template <class Sink>
+BasicParser<Sink>::BasicParser(const std::list<Token*>& tokens, Sink sink) : BasicParser(TokenBuffer(tokens), std::move(sink)) {
+
+}
+
+/**
+ * Constructor for the BasicParser, over tokens someone else holds, e.g.
+ * another parser's input. Token positions in errors count from first.
+ * @param first The first token, borrowed like the tokens of a TokenBuffer
+ * @param last The position of the end-of-input token after the last one
+ * @param sink Receives what is parsed
+ */
+template <class Sink>
+BasicParser<Sink>::BasicParser(Token* const* first, Token* const* last, Sink sink) : sink(std::move(sink)) {
+    this->first = first;
+    this->cursor = first;
+    this->last = last;
+    this->mode = ParseMode::Recursive;
+    this->maxDepth = 1 << 20;
+    this->recovering = false;
+    this->symbols = nullptr;
+    this->lazy = false;
+    this->prescanning = false;
+}
+
+/**
+ * Choose how nested statements and expressions are parsed
+ * @param mode Recursive descent, or an explicit heap-allocated stack
+ * @param maxDepth In ExplicitStack mode, the deepest nesting accepted before a ParseException
+ */
+template <class Sink>
+void BasicParser<Sink>::setMode(ParseMode mode, size_t maxDepth) {
+    this->mode = mode;
+    this->maxDepth = maxDepth;
+}
+
+/**
+ * Choose what happens when the input does not match the grammar
+ * @param recovering false to throw a ParseException at the first error. true to
+ *                   record every error in getErrors(), put an error token where
+ *                   the expected token is missing, skip ahead to the next
+ *                   statement or class member, and carry on, so a partial tree
+ *                   is always returned. Nesting deeper than the ExplicitStack
+ *                   depth limit still throws.
+ */
+template <class Sink>
+void BasicParser<Sink>::setRecovery(bool recovering) {
+    this->recovering = recovering;
+}
+
+/**
+ * Keep track of the variables in scope while parsing. compileClass() starts
+ * the table afresh, compileSubroutine() opens a scope for its arguments and
+ * locals and closes it when done, and every classVarDec, parameter and
+ * varDec is added as soon as its name is parsed. The table can be read at
+ * any point during the parse, e.g. by the Sink.
+ * @param symbols The table to fill, borrowed, or nullptr to keep no table
+ */
+template <class Sink>
+void BasicParser<Sink>::setSymbols(SymbolTable* symbols) {
+    this->symbols = symbols;
+}
+
+/**
+ * Skip subroutine bodies instead of parsing them. compileSubroutine() finds
+ * the end of each body by matching braces and leaves a lazySubroutineBody
+ * node holding just the two braces, which CompilerParser::expand() replaces
+ * with the parsed body when it is first needed. Class headers, classVarDecs
+ * and subroutine signatures are parsed as usual, so an outline of a class
+ * costs a fraction of a full parse. Grammar errors inside a body are only
+ * found when it is expanded, and its locals are never added to the symbols.
+ * Lazy mode has no effect in recovery mode: recovery in a body that is
+ * missing a brace can stop anywhere, and the parse of the class would go
+ * on from there, so the body could not be parsed on its own later.
+ * @param lazy true to skip bodies, false to parse everything
+ */
+template <class Sink>
+void BasicParser<Sink>::setLazy(bool lazy) {
+    this->lazy = lazy;
+}
+
+template <class Sink>
+void BasicParser<Sink>::printCurrent(){
+    std::cout << current()->getType() << " " << current()->getValue() << "\n";
+}
+
+
+/**
+ * Generates a parse tree for a single program
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileProgram() {
+    PROFILE_POINT(CompileProgram);
+
+    open(NodeKind::Class);
+
+    add(mustBe(NodeKind::Keyword, Atoms::Class));
+    add(mustBe(NodeKind::Identifier, ParserGrammar::MAIN));
+    add(mustBe(NodeKind::Symbol, Atoms::LeftBrace));
+    add(mustBe(NodeKind::Symbol, Atoms::RightBrace));
+
+    return close();
+}
+
+/**
+ * Generates a parse tree for a single class
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileClass() {
+    PROFILE_POINT(CompileClass);
+
+    open(NodeKind::Class);
+
+    /* class Name {
+        ...
+
+    */
+    add(mustBe(NodeKind::Keyword, Atoms::Class));
+
+    // a new class starts with no variables
+    if(symbols != nullptr){
+        symbols->startClass(current()->getKind() == NodeKind::Identifier ? current()->getAtom() : Atoms::Empty);
+    }
+
+    if(current()->getKind() == NodeKind::Identifier){
+        take(); //Main, Bob, Apple
+    }
+    else{
+        add(fail(NodeKind::Identifier));
+    }
+
+    add(mustBe(NodeKind::Symbol, Atoms::LeftBrace));
+
+    // class contents
+
+    // iterates over each variable declaration
+    bool done = false;
+    while(!done){
+        switch(current()->keyword()){
+            case Atoms::Static:
+            case Atoms::Field:
+                compileClassVarDec();
+                break;
+
+            default:
+                done = true;
+                break;
+        }
+    }
+
+    // iterates over each subroutine
+    done = false;
+    while(!done){
+        switch(current()->keyword()){
+            case Atoms::Function:
+            case Atoms::Method:
+            case Atoms::Constructor:
+                compileSubroutine();
+                break;
+
+            default:
+                done = true;
+                break;
+        }
+    }
+
+    // in recovery mode, skip anything else up to the next class member
+    while(recovering && !have(NodeKind::Symbol, Atoms::RightBrace) && current()->getKind() != NodeKind::Eof){
+        switch(current()->keyword()){
+            case Atoms::Static:
+            case Atoms::Field:
+                fail(NodeKind::Subroutine); // variables must come before subroutines
+                compileClassVarDec();
+                break;
+
+            case Atoms::Function:
+            case Atoms::Method:
+            case Atoms::Constructor:
+                compileSubroutine();
+                break;
+
+            default:
+                fail(NodeKind::Subroutine);
+                next();
+                skipToClassMember();
+                break;
+        }
+    }
+
+    // class end }
+    add(mustBe(NodeKind::Symbol, Atoms::RightBrace));
+
+    return close();
+}
+
+/**
+ * Generates a parse tree for a static variable declaration or field declaration
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileClassVarDec() {
+    PROFILE_POINT(CompileClassVarDec);
+
+    open(NodeKind::ClassVarDec);
+
+    //we have already established this is a either field or static
+    SymbolKind kind = current()->getAtom() == Atoms::Static ? SymbolKind::Static : SymbolKind::Field;
+    take();
+    // type of variable
+    Atom type = current()->getAtom();
+    add(sink.makeToken(NodeKind::Keyword, type));
+    next();
+
+    // iterating over each variable declaration
+    while(true){
+        if(current()->getKind() == NodeKind::Identifier){
+            declare(current()->getAtom(), type, kind);
+            take();
+        }
+        else if(have(NodeKind::Symbol, Atoms::Comma)){
+            take();
+        }
+        else if(have(NodeKind::Symbol, Atoms::Semicolon)){
+            take();
+            break;
+        }
+        else{
+            add(fail(NodeKind::Symbol, Atoms::Semicolon));
+            break;
+        }
+    }
+
+
+    return close();
+}
+
+
+
+/**
+ * Generates a parse tree for a method, function, or constructor
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileSubroutine() {
+    PROFILE_POINT(CompileSubroutine);
+
+    open(NodeKind::Subroutine);
+
+    // arguments and locals are only in scope inside the subroutine
+    if(symbols != nullptr){
+        symbols->pushScope();
+    }
+
+    //we have already established this is either constructor, function or method
+    if(current()->getAtom() == Atoms::Method && symbols != nullptr){
+        // a method's object is its first argument
+        symbols->define(Atoms::This, symbols->getClassName(), SymbolKind::Argument);
+    }
+    take();
+
+    if(current()->getKind() == NodeKind::Keyword || current()->getKind() == NodeKind::Identifier){
+        take();
+    }
+    else{
+        add(fail(NodeKind::Keyword));
+    }
+
+
+    if(current()->getKind() == NodeKind::Identifier){
+        take();
+    }
+    else{
+        add(fail(NodeKind::Identifier));
+    }
+
+
+    // compiling parameters...
+    add(mustBe(NodeKind::Symbol, Atoms::LeftParen));
+    compileParameterList();
+    add(mustBe(NodeKind::Symbol, Atoms::RightParen));
+
+    // compiling inside of subroutine, or only finding where it ends
+    if(!lazy || !skipSubroutineBody()){
+        compileSubroutineBody();
+    }
+
+    if(symbols != nullptr){
+        symbols->popScope();
+    }
+
+    return close();
+
+}
+
+/**
+ * Generates a parse tree for a subroutine's parameters
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileParameterList() {
+    PROFILE_POINT(CompileParameterList);
+    open(NodeKind::ParameterList);
+
+    if(have(NodeKind::Symbol, Atoms::RightParen)){
+        return close();
+    }
+
+
+    // iterate each parameter...
+    while(true){
+
+        // type of parameter, either built in type (keyword) or className (identifier)
+        Atom type = Atoms::Empty;
+        if(current()->getKind() == NodeKind::Keyword || current()->getKind() == NodeKind::Identifier){
+            type = current()->getAtom();
+            take();
+        }
+        else{
+            add(fail(NodeKind::Keyword));
+        }
+
+        // name of parameter
+        if(current()->getKind() == NodeKind::Identifier){
+            declare(current()->getAtom(), type, SymbolKind::Argument);
+            take();
+        }
+        else{
+            add(fail(NodeKind::Identifier));
+        }
+
+        // (int a, int b)
+
+        if(!have(NodeKind::Symbol, Atoms::Comma)){
+            break;
+        }
+        else{
+            // adding ','
+            take();
+        }
+    }
+    return close();
+}
+
+/**
+ * Generates a parse tree for a subroutine's body
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileSubroutineBody() {
+    PROFILE_POINT(CompileSubroutineBody);
+
+    open(NodeKind::SubroutineBody);
+
+    add(mustBe(NodeKind::Symbol, Atoms::LeftBrace));
+
+    // iterating over each var declaration
+    while(true){
+        if(have(NodeKind::Keyword, Atoms::Var)){
+            compileVarDec();
+        }
+        else{
+            break;
+        }
+    }
+
+    // iterates over each statement
+    if(!have(NodeKind::Symbol, Atoms::RightBrace)){
+        compileStatements();
+    }
+    add(mustBe(NodeKind::Symbol, Atoms::RightBrace));
+
+    return close();
+}
+
+/**
+ * Find the end of a subroutine body by matching braces alone, and leave a
+ * lazySubroutineBody holding its opening and closing brace in its place
+ * @return true if the body was skipped, false if its braces do not match or
+ *         the parser is in recovery mode (see setLazy()), in which case
+ *         nothing was consumed and it must be parsed
+ */
+template <class Sink>
+bool BasicParser<Sink>::skipSubroutineBody() {
+    if(!have(NodeKind::Symbol, Atoms::LeftBrace) || (recovering && !prescanning)){
+        return false;
+    }
+
+    Token* const* end = cursor;
+    size_t depth = 0;
+    do{
+        if((*end)->is(NodeKind::Symbol, Atoms::LeftBrace)){
+            depth++;
+        }
+        else if((*end)->is(NodeKind::Symbol, Atoms::RightBrace)){
+            depth--;
+        }
+        end++;
+    } while(depth > 0 && end != last);
+
+    if(depth > 0){
+        return false;
+    }
+
+    size_t start = cursor - first;
+    open(NodeKind::LazySubroutineBody);
+    add(*cursor);
+    add(*(end - 1));
+    cursor = end;
+
+    // sinks that build no tree have no placeholder to expand later
+    ParseTree* placeholder = close();
+    if(placeholder != nullptr){
+        lazyBodies[placeholder] = start;
+    }
+    return true;
+}
+
+/**
+ * Generates a parse tree for a subroutine variable declaration
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileVarDec() {
+    PROFILE_POINT(CompileVarDec);
+
+    open(NodeKind::VarDec);
+
+    add(mustBe(NodeKind::Keyword, Atoms::Var));
+
+    // type of var, either built in type (keyword) or className (identifier)
+    Atom type = Atoms::Empty;
+    if(current()->getKind() == NodeKind::Keyword || current()->getKind() == NodeKind::Identifier){
+        type = current()->getAtom();
+        take();
+    }
+    else{
+        add(fail(NodeKind::Keyword));
+    }
+
+    // iterating over each variable declaration
+    while(true){
+
+        if(current()->getKind() == NodeKind::Identifier){
+            declare(current()->getAtom(), type, SymbolKind::Local);
+            take();
+        }
+        else if(have(NodeKind::Symbol, Atoms::Comma)){
+            take();
+        }
+        else if(have(NodeKind::Symbol, Atoms::Semicolon)){
+            take();
+            break;
+        }
+        else{
+            add(fail(NodeKind::Symbol, Atoms::Semicolon));
+            break;
+        }
+    }
+
+    return close();
+}
+
+/**
+ * Generates a parse tree for a series of statements
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileStatements() {
+    PROFILE_POINT(CompileStatements);
+
+    if(mode == ParseMode::ExplicitStack){
+        return iterateStatements();
+    }
+
+    open(NodeKind::Statements);
+
+    // iterate over each statement, each one consumes its own closing ; or }
+    // one switch on the keyword id picks the statement
+    bool done = false;
+    while(!done){
+        switch(current()->keyword()){
+            case Atoms::Return:
+                compileReturn();
+                break;
+
+            case Atoms::Let:
+                compileLet();
+                break;
+
+            case Atoms::If:
+                compileIf();
+                break;
+
+            case Atoms::While:
+                compileWhile();
+                break;
+
+            case Atoms::Do:
+                compileDo();
+                break;
+
+            default:
+                if(recovering && !endsStatements()){
+                    fail(NodeKind::Statements);
+                    skipToStatement();
+                }
+                else{
+                    done = true;
+                }
+                break;
+        }
+    }
+
+    return close();
+}
+
+/**
+ * Generates a parse tree for a let statement
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileLet() {
+    PROFILE_POINT(CompileLet);
+
+    open(NodeKind::LetStatement);
+
+    add(mustBe(NodeKind::Keyword, Atoms::Let));
+
+    // variable being assigned
+    if(current()->getKind() == NodeKind::Identifier){
+        take();
+    }
+    else{
+        add(fail(NodeKind::Identifier));
+    }
+
+    // array element being assigned, a[i] = ...
+    if(have(NodeKind::Symbol, Atoms::LeftBracket)){
+        take();
+        compileExpression();
+        add(mustBe(NodeKind::Symbol, Atoms::RightBracket));
+    }
+
+    add(mustBe(NodeKind::Symbol, Atoms::Equals));
+    compileExpression();
+    add(mustBe(NodeKind::Symbol, Atoms::Semicolon));
+
+    return close();
+}
+
+/**
+ * Generates a parse tree for an if statement
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileIf() {
+    PROFILE_POINT(CompileIf);
+
+    open(NodeKind::IfStatement);
+
+    add(mustBe(NodeKind::Keyword, Atoms::If));
+
+    add(mustBe(NodeKind::Symbol, Atoms::LeftParen));
+    compileExpression();
+    add(mustBe(NodeKind::Symbol, Atoms::RightParen));
+
+    add(mustBe(NodeKind::Symbol, Atoms::LeftBrace));
+    compileStatements();
+    add(mustBe(NodeKind::Symbol, Atoms::RightBrace));
+
+    if(have(NodeKind::Keyword, Atoms::Else)){
+        take();
+        add(mustBe(NodeKind::Symbol, Atoms::LeftBrace));
+        compileStatements();
+        add(mustBe(NodeKind::Symbol, Atoms::RightBrace));
+    }
+
+    return close();
+}
+
+/**
+ * Generates a parse tree for a while statement
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileWhile() {
+    PROFILE_POINT(CompileWhile);
+
+    open(NodeKind::WhileStatement);
+
+    add(mustBe(NodeKind::Keyword, Atoms::While));
+
+    add(mustBe(NodeKind::Symbol, Atoms::LeftParen));
+    compileExpression();
+    add(mustBe(NodeKind::Symbol, Atoms::RightParen));
+
+    add(mustBe(NodeKind::Symbol, Atoms::LeftBrace));
+    compileStatements();
+    add(mustBe(NodeKind::Symbol, Atoms::RightBrace));
+
+    return close();
+}
+/**
+ * Generates a parse tree for a do statement
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileDo() {
+    PROFILE_POINT(CompileDo);
+
+    open(NodeKind::DoStatement);
+
+    add(mustBe(NodeKind::Keyword, Atoms::Do));
+
+    compileExpression();
+
+    add(mustBe(NodeKind::Symbol, Atoms::Semicolon));
+    return close();
+}
+
+/**
+ * Generates a parse tree for a return statement
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileReturn() {
+    PROFILE_POINT(CompileReturn);
+
+    open(NodeKind::ReturnStatement);
+
+    add(mustBe(NodeKind::Keyword, Atoms::Return));
+
+    if(have(NodeKind::Symbol, Atoms::Semicolon)){
+        take();
+        return close();
+    }
+    else {
+        compileExpression();
+    }
+    add(mustBe(NodeKind::Symbol, Atoms::Semicolon));
+
+    return close();
+
+}
+
+/**
+ * Generates a parse tree for an expression
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileExpression() {
+    PROFILE_POINT(CompileExpression);
+
+    if(mode == ParseMode::ExplicitStack){
+        return iterateExpression(NodeKind::Expression);
+    }
+
+    open(NodeKind::Expression);
+
+    //check if the expression is just a term
+    if(have(NodeKind::Keyword, ParserGrammar::SKIP)) {
+        take();
+        return close();
+    }
+
+    compileBinary(0);
+    return close();
+}
+
+/**
+ * Precedence climbing over binary operators. Operators of equal precedence
+ * group to the left, so a - b - c becomes ((a - b) - c).
+ * @param minPrecedence The weakest operator this call may consume
+ * @return a term, or a binaryExpression of (left operand, operator, right operand)
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileBinary(int minPrecedence) {
+    PROFILE_POINT(CompileBinary);
+
+    size_t start = mark();
+    ParseTree* left = compileTerm();
+
+    while(true){
+        int precedence = ParserGrammar::binaryPrecedence(current());
+        if(precedence < minPrecedence){
+            break;
+        }
+
+        wrap(start, NodeKind::BinaryExpression);
+        take();
+        compileBinary(precedence + 1);
+        left = close();
+    }
+
+    return left;
+}
+
+/**
+ * Generates a parse tree for an expression term
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileTerm() {
+    PROFILE_POINT(CompileTerm);
+
+    if(mode == ParseMode::ExplicitStack){
+        return iterateExpression(NodeKind::Term);
+    }
+
+    open(NodeKind::Term);
+
+    Token* token = current();
+
+    switch(token->getKind()){
+        case NodeKind::IntegerConstant:
+        case NodeKind::StringConstant:
+        case NodeKind::KeywordConstant:
+            take();
+            return close();
+
+        case NodeKind::Keyword:
+            // true, false, null, this
+            if(token->getAtom() == Atoms::True || token->getAtom() == Atoms::False
+            || token->getAtom() == Atoms::Null || token->getAtom() == Atoms::This){
+                take();
+                return close();
+            }
+            break;
+
+        case NodeKind::Identifier:
+            take();
+
+            // array element a[i]
+            if(have(NodeKind::Symbol, Atoms::LeftBracket)){
+                take();
+                compileExpression();
+                add(mustBe(NodeKind::Symbol, Atoms::RightBracket));
+            }
+            // subroutine call f(...) or Name.f(...)
+            else if(have(NodeKind::Symbol, Atoms::LeftParen) || have(NodeKind::Symbol, Atoms::Dot)){
+                if(have(NodeKind::Symbol, Atoms::Dot)){
+                    take();
+                    if(current()->getKind() == NodeKind::Identifier){
+                        take();
+                    }
+                    else{
+                        add(fail(NodeKind::Identifier));
+                    }
+                }
+                add(mustBe(NodeKind::Symbol, Atoms::LeftParen));
+                compileExpressionList();
+                add(mustBe(NodeKind::Symbol, Atoms::RightParen));
+            }
+            return close();
+
+        case NodeKind::Symbol:
+            // sub expression
+            if(token->getAtom() == Atoms::LeftParen){
+                take();
+                compileExpression();
+                add(mustBe(NodeKind::Symbol, Atoms::RightParen));
+                return close();
+            }
+            // unary operator applied to a term
+            if(token->getAtom() == Atoms::Minus || token->getAtom() == Atoms::Tilde){
+                take();
+                compileTerm();
+                return close();
+            }
+            break;
+
+        case NodeKind::UnaryOp:
+            take();
+            compileTerm();
+            return close();
+
+        default:
+            break;
+    }
+
+    add(fail(NodeKind::Term));
+    return close();
+}
+
+/**
+ * Generates a parse tree for an expression list
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::compileExpressionList() {
+    PROFILE_POINT(CompileExpressionList);
+
+    if(mode == ParseMode::ExplicitStack){
+        return iterateExpression(NodeKind::ExpressionList);
+    }
+
+    open(NodeKind::ExpressionList);
+
+    if(have(NodeKind::Symbol, Atoms::RightParen)){
+        return close();
+    }
+
+    compileExpression();
+    while(have(NodeKind::Symbol, Atoms::Comma)){
+        take();
+        compileExpression();
+    }
+
+    return close();
+}
+
+/**
+ * Push a frame onto an explicit parse stack, enforcing the depth limit
+ * @param stack The stack
+ * @param frame The production to start
+ */
+template <class Sink>
+void BasicParser<Sink>::push(std::vector<Frame>& stack, Frame frame){
+    if(stack.size() >= maxDepth){
+        throw ParseException(); // nested deeper than the configured limit
+    }
+    stack.push_back(frame);
+}
+
+/**
+ * compileStatements() without recursion: nested if/while bodies are kept on
+ * a heap-allocated stack. Builds the same tree as the recursive version.
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::iterateStatements() {
+    PROFILE_POINT(IterateStatements);
+
+    std::vector<Frame> stack;
+    push(stack, {NodeKind::Statements, START, 0, 0});
+    open(NodeKind::Statements);
+
+    while(true){
+        Frame& frame = stack.back();
+        bool done = false;
+
+        if(frame.kind == NodeKind::Statements){
+            Atom keyword = current()->keyword();
+            switch(keyword){
+                case Atoms::Return:
+                    compileReturn();
+                    break;
+
+                case Atoms::Let:
+                    compileLet();
+                    break;
+
+                case Atoms::Do:
+                    compileDo();
+                    break;
+
+                case Atoms::If:
+                case Atoms::While: {
+                    NodeKind kind = keyword == Atoms::If ? NodeKind::IfStatement : NodeKind::WhileStatement;
+                    open(kind);
+                    take();
+                    add(mustBe(NodeKind::Symbol, Atoms::LeftParen));
+                    compileExpression();
+                    add(mustBe(NodeKind::Symbol, Atoms::RightParen));
+                    add(mustBe(NodeKind::Symbol, Atoms::LeftBrace));
+
+                    push(stack, {kind, AFTER_BODY, 0, 0});
+                    push(stack, {NodeKind::Statements, START, 0, 0});
+                    open(NodeKind::Statements);
+                    break;
+                }
+
+                default:
+                    if(recovering && !endsStatements()){
+                        fail(NodeKind::Statements);
+                        skipToStatement();
+                    }
+                    else{
+                        done = true;
+                    }
+                    break;
+            }
+        }
+        else if(frame.state == AFTER_BODY){
+            add(mustBe(NodeKind::Symbol, Atoms::RightBrace));
+
+            if(frame.kind == NodeKind::IfStatement && have(NodeKind::Keyword, Atoms::Else)){
+                take();
+                add(mustBe(NodeKind::Symbol, Atoms::LeftBrace));
+                frame.state = AFTER_ELSE;
+                push(stack, {NodeKind::Statements, START, 0, 0});
+                open(NodeKind::Statements);
+            }
+            else{
+                done = true;
+            }
+        }
+        else{
+            // AFTER_ELSE
+            add(mustBe(NodeKind::Symbol, Atoms::RightBrace));
+            done = true;
+        }
+
+        if(done){
+            ParseTree* finished = close();
+            stack.pop_back();
+            if(stack.empty()){
+                return finished;
+            }
+        }
+    }
+}
+
+/**
+ * compileExpression(), compileTerm() and compileExpressionList() without
+ * recursion: nested expressions are kept on a heap-allocated stack.
+ * Builds the same tree as the recursive versions.
+ * @param start NodeKind::Expression, NodeKind::Term or NodeKind::ExpressionList
+ * @return a ParseTree
+ */
+template <class Sink>
+ParseTree* BasicParser<Sink>::iterateExpression(NodeKind start) {
+    PROFILE_POINT(IterateExpression);
+
+    std::vector<Frame> stack;
+    push(stack, {start, START, 0, 0});
+
+    // the node closed most recently, returned once the stack is empty
+    ParseTree* finished = nullptr;
+
+    while(true){
+        Frame& frame = stack.back();
+        bool done = false;
+
+        switch(frame.kind){
+            case NodeKind::Expression:
+                if(frame.state == START){
+                    open(NodeKind::Expression);
+                    if(have(NodeKind::Keyword, ParserGrammar::SKIP)){
+                        take();
+                        done = true;
+                    }
+                    else{
+                        frame.state = AFTER_CHILD;
+                        push(stack, {NodeKind::BinaryExpression, START, 0, 0});
+                    }
+                }
+                else{
+                    done = true;
+                }
+                break;
+
+            case NodeKind::BinaryExpression:
+                // one call of compileBinary(), which owns no node of its own
+                if(frame.state == START){
+                    frame.start = mark();
+                    frame.state = AFTER_CHILD;
+                    push(stack, {NodeKind::Term, START, 0, 0});
+                    break;
+                }
+                if(frame.state == AFTER_OPERATOR){
+                    finished = close();
+                }
+
+                if(ParserGrammar::binaryPrecedence(current()) >= frame.minPrecedence){
+                    int precedence = ParserGrammar::binaryPrecedence(current());
+                    wrap(frame.start, NodeKind::BinaryExpression);
+                    take();
+                    frame.state = AFTER_OPERATOR;
+                    push(stack, {NodeKind::BinaryExpression, START, 0, precedence + 1});
+                }
+                else{
+                    stack.pop_back();
+                    continue;
+                }
+                break;
+
+            case NodeKind::ExpressionList:
+                if(frame.state == START){
+                    open(NodeKind::ExpressionList);
+                    if(have(NodeKind::Symbol, Atoms::RightParen)){
+                        done = true;
+                    }
+                    else{
+                        frame.state = AFTER_CHILD;
+                        push(stack, {NodeKind::Expression, START, 0, 0});
+                    }
+                }
+                else{
+                    if(have(NodeKind::Symbol, Atoms::Comma)){
+                        take();
+                        push(stack, {NodeKind::Expression, START, 0, 0});
+                    }
+                    else{
+                        done = true;
+                    }
+                }
+                break;
+
+            default:
+                // NodeKind::Term
+                if(frame.state == START){
+                    open(NodeKind::Term);
+                    Token* token = current();
+                    Atom value = token->getAtom();
+                    done = true;
+
+                    switch(token->getKind()){
+                        case NodeKind::IntegerConstant:
+                        case NodeKind::StringConstant:
+                        case NodeKind::KeywordConstant:
+                            take();
+                            break;
+
+                        case NodeKind::Keyword:
+                            if(value != Atoms::True && value != Atoms::False
+                            && value != Atoms::Null && value != Atoms::This){
+                                add(fail(NodeKind::Term));
+                                break;
+                            }
+                            take();
+                            break;
+
+                        case NodeKind::Identifier:
+                            take();
+                            if(have(NodeKind::Symbol, Atoms::LeftBracket)){
+                                take();
+                                frame.state = AFTER_INDEX;
+                                done = false;
+                                push(stack, {NodeKind::Expression, START, 0, 0});
+                            }
+                            else if(have(NodeKind::Symbol, Atoms::LeftParen) || have(NodeKind::Symbol, Atoms::Dot)){
+                                if(have(NodeKind::Symbol, Atoms::Dot)){
+                                    take();
+                                    if(current()->getKind() == NodeKind::Identifier){
+                                        take();
+                                    }
+                                    else{
+                                        add(fail(NodeKind::Identifier));
+                                    }
+                                }
+                                add(mustBe(NodeKind::Symbol, Atoms::LeftParen));
+                                frame.state = AFTER_ARGUMENTS;
+                                done = false;
+                                push(stack, {NodeKind::ExpressionList, START, 0, 0});
+                            }
+                            break;
+
+                        case NodeKind::Symbol:
+                            if(value == Atoms::LeftParen){
+                                take();
+                                frame.state = AFTER_GROUP;
+                                done = false;
+                                push(stack, {NodeKind::Expression, START, 0, 0});
+                            }
+                            else if(value == Atoms::Minus || value == Atoms::Tilde){
+                                take();
+                                frame.state = AFTER_OPERAND;
+                                done = false;
+                                push(stack, {NodeKind::Term, START, 0, 0});
+                            }
+                            else{
+                                add(fail(NodeKind::Term));
+                            }
+                            break;
+
+                        case NodeKind::UnaryOp:
+                            take();
+                            frame.state = AFTER_OPERAND;
+                            done = false;
+                            push(stack, {NodeKind::Term, START, 0, 0});
+                            break;
+
+                        default:
+                            add(fail(NodeKind::Term));
+                            break;
+                    }
+                }
+                else{
+                    if(frame.state == AFTER_INDEX){
+                        add(mustBe(NodeKind::Symbol, Atoms::RightBracket));
+                    }
+                    else if(frame.state == AFTER_ARGUMENTS || frame.state == AFTER_GROUP){
+                        add(mustBe(NodeKind::Symbol, Atoms::RightParen));
+                    }
+                    done = true;
+                }
+                break;
+        }
+
+        if(done){
+            finished = close();
+            stack.pop_back();
+        }
+        if(stack.empty()){
+            return finished;
+        }
+    }
+}
+
+/**
+ * Advance to the next token. The parser stays on the end-of-input token once it gets there.
+ */
+template <class Sink>
+void BasicParser<Sink>::next(){
+    PROFILE_POINT(Next);
+    if(cursor != last){
+        cursor++;
+    }
+}
+
+/**
+ * Check if the current token matches the expected type and value.
+ * If so, advance to the next token, returning the current token, otherwise fail().
+ * @return the current token before advancing, or an error token in recovery mode
+ */
+template <class Sink>
+Token* BasicParser<Sink>::mustBe(NodeKind expectedKind, Atom expectedValue){
+    PROFILE_POINT(MustBe);
+    auto token = current();
+    
+    if(token->is(expectedKind, expectedValue)){
+        next();
+        return token;
+    }
+    return fail(expectedKind, expectedValue);
+}
+
+/**
+ * Report that the current token is not what the grammar expected.
+ * Throws a ParseException, unless in recovery mode, where the error is recorded
+ * (once per token, so one bad token does not cascade) and parsing goes on.
+ * The current token is not consumed.
+ * @param expectedKind The type of token or node that was expected
+ * @param expectedValue The value that was expected, Atoms::Empty if any would do
+ * @return An error token to put in the tree where the expected one is missing
+ */
+template <class Sink>
+Token* BasicParser<Sink>::fail(NodeKind expectedKind, Atom expectedValue){
+    if(!recovering){
+        throw ParseException();
+    }
+
+    size_t index = (size_t) (cursor - first);
+    if(errors.empty() || errors.back().token != index){
+        errors.push_back({index, expectedKind, expectedValue, current()});
+    }
+    return sink.makeToken(NodeKind::Error, expectedValue);
+}
+
+/**
+ * Check for a token that ends a run of statements: the closing brace of the
+ * block, the start of the next class member, or the end of input
+ * @return true if compileStatements() should stop here
+ */
+template <class Sink>
+bool BasicParser<Sink>::endsStatements(){
+    Token* token = current();
+    switch(token->keyword()){
+        case Atoms::Function:
+        case Atoms::Method:
+        case Atoms::Constructor:
+        case Atoms::Static:
+        case Atoms::Field:
+            return true;
+
+        default:
+            return token->getKind() == NodeKind::Eof || token->is(NodeKind::Symbol, Atoms::RightBrace);
+    }
+}
+
+/**
+ * Panic-mode recovery inside a block: skip tokens up to the start of the
+ * next statement, past the next ; or { block }, or up to anything that
+ * ends the block
+ */
+template <class Sink>
+void BasicParser<Sink>::skipToStatement(){
+    while(!endsStatements()){
+        Token* token = current();
+        switch(token->keyword()){
+            case Atoms::Let:
+            case Atoms::If:
+            case Atoms::While:
+            case Atoms::Do:
+            case Atoms::Return:
+                return;
+
+            default:
+                break;
+        }
+        next();
+        if(token->is(NodeKind::Symbol, Atoms::Semicolon)){
+            return;
+        }
+
+        // a block after a bad statement belongs to it, so its closing brace does not end this one
+        if(token->is(NodeKind::Symbol, Atoms::LeftBrace)){
+            int depth = 1;
+            while(depth > 0 && current()->getKind() != NodeKind::Eof){
+                if(have(NodeKind::Symbol, Atoms::LeftBrace)){
+                    depth++;
+                }
+                else if(have(NodeKind::Symbol, Atoms::RightBrace)){
+                    depth--;
+                }
+                next();
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * Panic-mode recovery inside a class: skip tokens up to the next class
+ * member, the closing brace, or the end of input
+ */
+template <class Sink>
+void BasicParser<Sink>::skipToClassMember(){
+    while(!endsStatements()){
+        next();
+    }
+}
+
+#endif /*BASICPARSER_TPP*/
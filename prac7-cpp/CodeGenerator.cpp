@@ -0,0 +1,412 @@
+#include "CodeGenerator.h"
+
+#include "BasicParser.tpp"
+
+using namespace std;
+
+template class BasicParser<CodeGenerator>;
+
+/**
+ * The segment a variable of each SymbolKind lives in
+ */
+static Segment segmentOf(SymbolKind kind) {
+    switch (kind) {
+        case SymbolKind::Static:
+            return Segment::Static;
+        case SymbolKind::Field:
+            return Segment::This;
+        case SymbolKind::Argument:
+            return Segment::Argument;
+        default:
+            return Segment::Local;
+    }
+}
+
+/**
+ * A generator that writes VM code for each class it is given
+ * @param out Where the code goes, borrowed
+ * @param symbols The table the parser fills, borrowed
+ */
+CodeGenerator::CodeGenerator(OutputBuffer& out, const SymbolTable& symbols) : writer(out), symbols(symbols) {
+    this->arena = make_unique<Arena>();
+    this->subroutineKind = Atoms::Empty;
+    this->subroutineName = Atoms::Empty;
+    this->headerWritten = false;
+    this->ifCount = 0;
+    this->whileCount = 0;
+}
+
+/**
+ * Write the function command of the current subroutine, once its locals are
+ * all declared, followed by the code that sets up this for constructors
+ * and methods
+ */
+void CodeGenerator::writeHeader() {
+    if (headerWritten || subroutineKind == Atoms::Empty) {
+        return;
+    }
+    headerWritten = true;
+
+    Interner& interner = Interner::global();
+    writer.writeFunction(interner.str(symbols.getClassName()), interner.str(subroutineName), symbols.count(SymbolKind::Local));
+
+    if (subroutineKind == Atoms::Constructor) {
+        writer.writePush(Segment::Constant, symbols.count(SymbolKind::Field));
+        writer.writeCall("Memory", "alloc", 1);
+        writer.writePop(Segment::Pointer, 0);
+    }
+    else if (subroutineKind == Atoms::Method) {
+        writer.writePush(Segment::Argument, 0);
+        writer.writePop(Segment::Pointer, 0);
+    }
+}
+
+/**
+ * Push the value of a variable
+ * @param name The variable's name; an error is recorded if it was never declared
+ */
+void CodeGenerator::pushVariable(Atom name) {
+    const Symbol* symbol = symbols.lookup(name);
+    if (symbol == nullptr) {
+        errors.push_back("undefined variable '" + Interner::global().str(name) + "'");
+        return;
+    }
+    writer.writePush(segmentOf(symbol->kind), symbol->index);
+}
+
+/**
+ * Pop the top of the stack into a variable
+ * @param name The variable's name; an error is recorded if it was never declared
+ */
+void CodeGenerator::popVariable(Atom name) {
+    const Symbol* symbol = symbols.lookup(name);
+    if (symbol == nullptr) {
+        errors.push_back("undefined variable '" + Interner::global().str(name) + "'");
+        return;
+    }
+    writer.writePop(segmentOf(symbol->kind), symbol->index);
+}
+
+/**
+ * Push an integer constant, or build a String object for a string constant
+ * @param token An integerConstant or stringConstant token
+ */
+void CodeGenerator::pushConstant(const Token* token) {
+    const string& text = Interner::global().str(token->getAtom());
+
+    if (token->getKind() == NodeKind::IntegerConstant) {
+        uint32_t value = 0;
+        for (char c : text) {
+            value = value * 10 + (uint32_t) (c - '0');
+        }
+        writer.writePush(Segment::Constant, value);
+        return;
+    }
+
+    writer.writePush(Segment::Constant, (uint32_t) text.size());
+    writer.writeCall("String", "new", 1);
+    for (char c : text) {
+        writer.writePush(Segment::Constant, (unsigned char) c);
+        writer.writeCall("String", "appendChar", 2);
+    }
+}
+
+/**
+ * Work out what a term that calls a subroutine calls, once its '(' is
+ * reached, and push the object first if it is a method call
+ * @param term The term: name is the identifier before the '(' or '.',
+ *             member the identifier after the '.' if there is one
+ */
+void CodeGenerator::prepareCall(Context& term) {
+    term.pending = false;
+    term.flag = true;
+
+    if (term.member != Atoms::Empty) {
+        // var.f(...) calls a method of var's class, Name.f(...) a function of class Name
+        const Symbol* symbol = symbols.lookup(term.name);
+        if (symbol != nullptr) {
+            pushVariable(term.name);
+            term.name = symbol->type;
+            term.label = 1;
+        }
+    }
+    else {
+        // f(...) calls a method of this class on this
+        writer.writePush(Segment::Pointer, 0);
+        term.member = term.name;
+        term.name = symbols.getClassName();
+        term.label = 1;
+    }
+}
+
+/**
+ * Write what is left of a term once all of it has been parsed
+ * @param term The term
+ */
+void CodeGenerator::finishTerm(Context& term) {
+    if (term.pending) {
+        pushVariable(term.name);
+    }
+    else if (term.flag) {
+        Interner& interner = Interner::global();
+        writer.writeCall(interner.str(term.name), interner.str(term.member), term.count + term.label);
+    }
+
+    if (term.op == Atoms::Minus) {
+        writer.writeArithmetic("neg");
+    }
+    else if (term.op == Atoms::Tilde) {
+        writer.writeArithmetic("not");
+    }
+}
+
+/**
+ * The parser has started a production
+ * @param kind The type of the production
+ */
+void CodeGenerator::enter(NodeKind kind) {
+    stack.push_back({kind, 0, Atoms::Empty, Atoms::Empty, Atoms::Empty, false, false, 0, 0});
+    Context& context = stack.back();
+
+    switch (kind) {
+        case NodeKind::Subroutine:
+            subroutineKind = Atoms::Empty;
+            subroutineName = Atoms::Empty;
+            headerWritten = false;
+            ifCount = 0;
+            whileCount = 0;
+            break;
+
+        case NodeKind::Statements:
+            // every varDec comes before the first statement
+            writeHeader();
+            break;
+
+        case NodeKind::IfStatement:
+            context.label = ifCount++;
+            break;
+
+        case NodeKind::WhileStatement:
+            context.label = whileCount++;
+            writer.writeLabel("WHILE_EXP", context.label);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * The parser has started a production whose first child is the one it
+ * just finished. The code for that child has already been written, so this
+ * is the same as enter().
+ * @param mark Unused
+ * @param kind The type of the production, a binaryExpression
+ */
+void CodeGenerator::wrap(size_t, NodeKind kind) {
+    enter(kind);
+}
+
+/**
+ * The parser has accepted a token in the innermost production
+ * @param token The token
+ */
+void CodeGenerator::token(Token* token) {
+    if (stack.empty() || token->getKind() == NodeKind::Error) {
+        return;
+    }
+
+    Context& context = stack.back();
+    uint32_t position = context.tokens++;
+    NodeKind kind = token->getKind();
+    Atom value = token->getAtom();
+    bool symbol = kind == NodeKind::Symbol;
+
+    switch (context.kind) {
+        case NodeKind::Subroutine:
+            // constructor|function|method type name ( ... )
+            if (position == 0) {
+                subroutineKind = value;
+            }
+            else if (position == 2) {
+                subroutineName = value;
+            }
+            break;
+
+        case NodeKind::SubroutineBody:
+            if (symbol && value == Atoms::RightBrace) {
+                writeHeader(); // a body with no statements
+            }
+            break;
+
+        case NodeKind::LetStatement:
+            // let name [ index ] = value ;
+            if (kind == NodeKind::Identifier && position == 1) {
+                context.name = value;
+            }
+            else if (symbol && value == Atoms::LeftBracket) {
+                context.flag = true;
+                pushVariable(context.name);
+            }
+            else if (symbol && value == Atoms::RightBracket) {
+                writer.writeArithmetic("add");
+            }
+            break;
+
+        case NodeKind::IfStatement:
+            if (symbol && value == Atoms::RightParen) {
+                writer.writeArithmetic("not");
+                writer.writeIf("IF_FALSE", context.label);
+            }
+            else if (kind == NodeKind::Keyword && value == Atoms::Else) {
+                context.flag = true;
+                writer.writeGoto("IF_END", context.label);
+                writer.writeLabel("IF_FALSE", context.label);
+            }
+            break;
+
+        case NodeKind::WhileStatement:
+            if (symbol && value == Atoms::RightParen) {
+                writer.writeArithmetic("not");
+                writer.writeIf("WHILE_END", context.label);
+            }
+            break;
+
+        case NodeKind::Expression:
+            // skip
+            writer.writePush(Segment::Constant, 0);
+            break;
+
+        case NodeKind::BinaryExpression:
+            context.op = value;
+            break;
+
+        case NodeKind::Term:
+            if (position == 0) {
+                if (kind == NodeKind::IntegerConstant || kind == NodeKind::StringConstant) {
+                    pushConstant(token);
+                }
+                else if (kind == NodeKind::Identifier) {
+                    context.name = value;
+                    context.pending = true;
+                }
+                else if (value == Atoms::True) {
+                    writer.writePush(Segment::Constant, 0);
+                    writer.writeArithmetic("not");
+                }
+                else if (value == Atoms::False || value == Atoms::Null) {
+                    writer.writePush(Segment::Constant, 0);
+                }
+                else if (value == Atoms::This) {
+                    writer.writePush(Segment::Pointer, 0);
+                }
+                else if (value == Atoms::Minus || value == Atoms::Tilde) {
+                    context.op = value;
+                }
+            }
+            else if (kind == NodeKind::Identifier) {
+                context.member = value;
+            }
+            else if (symbol && value == Atoms::LeftBracket) {
+                context.pending = false;
+                pushVariable(context.name);
+            }
+            else if (symbol && value == Atoms::RightBracket) {
+                writer.writeArithmetic("add");
+                writer.writePop(Segment::Pointer, 1);
+                writer.writePush(Segment::That, 0);
+            }
+            else if (symbol && value == Atoms::LeftParen) {
+                prepareCall(context);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * The parser has finished the innermost production
+ * @return nullptr, as there is no tree
+ */
+ParseTree* CodeGenerator::leave() {
+    Context context = stack.back();
+    stack.pop_back();
+    Context* parent = stack.empty() ? nullptr : &stack.back();
+
+    switch (context.kind) {
+        case NodeKind::LetStatement:
+            if (context.flag) {
+                // the element's address is under the value
+                writer.writePop(Segment::Temp, 0);
+                writer.writePop(Segment::Pointer, 1);
+                writer.writePush(Segment::Temp, 0);
+                writer.writePop(Segment::That, 0);
+            }
+            else {
+                popVariable(context.name);
+            }
+            break;
+
+        case NodeKind::IfStatement:
+            if (context.flag) {
+                writer.writeLabel("IF_END", context.label);
+            }
+            else {
+                writer.writeLabel("IF_FALSE", context.label);
+            }
+            break;
+
+        case NodeKind::WhileStatement:
+            writer.writeGoto("WHILE_EXP", context.label);
+            writer.writeLabel("WHILE_END", context.label);
+            break;
+
+        case NodeKind::DoStatement:
+            writer.writePop(Segment::Temp, 0);
+            break;
+
+        case NodeKind::ReturnStatement:
+            if (context.count == 0) {
+                writer.writePush(Segment::Constant, 0);
+            }
+            writer.writeReturn();
+            break;
+
+        case NodeKind::Expression:
+            if (parent != nullptr) {
+                parent->count++;
+            }
+            break;
+
+        case NodeKind::ExpressionList:
+            if (parent != nullptr) {
+                parent->count = context.count;
+            }
+            break;
+
+        case NodeKind::BinaryExpression:
+            switch (context.op) {
+                case Atoms::Plus:        writer.writeArithmetic("add"); break;
+                case Atoms::Minus:       writer.writeArithmetic("sub"); break;
+                case Atoms::Star:        writer.writeCall("Math", "multiply", 2); break;
+                case Atoms::Slash:       writer.writeCall("Math", "divide", 2); break;
+                case Atoms::Ampersand:   writer.writeArithmetic("and"); break;
+                case Atoms::Pipe:        writer.writeArithmetic("or"); break;
+                case Atoms::LessThan:    writer.writeArithmetic("lt"); break;
+                case Atoms::GreaterThan: writer.writeArithmetic("gt"); break;
+                case Atoms::Equals:      writer.writeArithmetic("eq"); break;
+                default: break;
+            }
+            break;
+
+        case NodeKind::Term:
+            finishTerm(context);
+            break;
+
+        default:
+            break;
+    }
+    return nullptr;
+}
@@ -0,0 +1,78 @@
+#ifndef CODEGENERATOR_H
+#define CODEGENERATOR_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Arena.h"
+#include "NodeKind.h"
+#include "SymbolTable.h"
+#include "Token.h"
+#include "VMWriter.h"
+
+/**
+ * The BasicParser Sink that compiles Jack to Hack VM code in a single pass.
+ * The code for each production is written as soon as the parser reports it,
+ * so no tree is built. Operands are always complete before their operator
+ * is reported, which is the order the stack machine needs. Variables are
+ * resolved in the SymbolTable the parser fills, see BasicParser::setSymbols().
+ */
+class CodeGenerator {
+    private:
+        // what is known about one production that has started but not finished
+        struct Context {
+            NodeKind kind;
+            uint32_t tokens;    // tokens seen directly inside this production
+            Atom name;          // let: the variable assigned; term: the identifier it starts with
+            Atom member;        // term: the subroutine after a dot
+            Atom op;            // binaryExpression: the operator; term: a unary operator
+            bool pending;       // term: name is a variable that has not been pushed yet
+            bool flag;          // let: assigns an array element; if: has an else branch; term: is a call
+            uint32_t label;     // if/while: the number of the labels; term: arguments pushed before the list
+            uint32_t count;     // expressions finished directly inside this production
+        };
+
+        VMWriter writer;
+        const SymbolTable& symbols;
+        std::unique_ptr<Arena> arena;   // the few tokens the parser makes
+        std::vector<Context> stack;
+        std::vector<std::string> errors;
+
+        Atom subroutineKind;
+        Atom subroutineName;
+        bool headerWritten;
+        uint32_t ifCount;
+        uint32_t whileCount;
+
+        void writeHeader();
+        void pushVariable(Atom name);
+        void popVariable(Atom name);
+        void pushConstant(const Token* token);
+        void prepareCall(Context& term);
+        void finishTerm(Context& term);
+
+    public:
+        CodeGenerator(OutputBuffer& out, const SymbolTable& symbols);
+
+        void enter(NodeKind kind);
+
+        void token(Token* token);
+
+        Token* makeToken(NodeKind kind, Atom value) {
+            return arena->make<Token>(kind, value, arena.get());
+        }
+
+        // nothing is built, so there are no positions to remember
+        size_t mark() const { return 0; }
+
+        void wrap(size_t mark, NodeKind kind);
+
+        ParseTree* leave();
+
+        // names used as variables that were never declared
+        const std::vector<std::string>& getErrors() const { return errors; }
+};
+
+#endif /*CODEGENERATOR_H*/
@@ -1,581 +1,279 @@
 #include "CompilerParser.h"
-#include <iostream>
 
-/**
- * Constructor for the CompilerParser
- * @param tokens A linked list of tokens to be parsed
- */
-CompilerParser::CompilerParser(std::list<Token*> tokens) {
-    this->tokens = tokens; // store our program tokens
-    tokenIterator = this->tokens.begin();
-    this->tokenCount = 0;
-}
+#include <algorithm>
+#include <exception>
+#include <new>
 
+#include "BasicParser.tpp"
+#include "ValidateSink.h"
 
-
-void CompilerParser::printCurrent(){
-    std::cout << current()->getType() << " " << current()->getValue() << "\n";
-}
-
+template class BasicParser<TreeSink>;
+template class BasicParser<ValidateSink>;
 
 /**
- * Generates a parse tree for a single program
+ * Generates the same tree as compileClass(), with the subroutine bodies
+ * parsed in parallel. The class is parsed in lazy mode first, which finds
+ * every body by matching braces. The bodies are then split into runs of
+ * consecutive subroutines, each run parsed on the pool by a parser and
+ * Arena of its own, and put back in source order. Errors are kept in
+ * source order too.
+ *
+ * If a body with errors makes recovery stop anywhere but at its matching
+ * brace, the sequential parse would go on from there, so the class is
+ * parsed again sequentially. So is a class whose symbols must be declared
+ * in order, see setSymbols().
+ *
+ * Each worker's Arena may reserve what is left under this parser's memory
+ * limit, and anything a worker throws is rethrown here once all are done.
+ * @param pool The threads to parse the bodies on
  * @return a ParseTree
+ * @throws ParseException if the class is not valid and the parser is not in recovery mode
+ * @throws std::bad_alloc if the tree needs more than the limit set with Arena::setLimit()
  */
-ParseTree* CompilerParser::compileProgram() {
-
-    ParseTree* result = new ParseTree("class", "");
-
-    result->addChild(mustBe("keyword", "class"));
-    result->addChild(mustBe("identifier", "Main"));
-    result->addChild(mustBe("symbol", "{"));
-    result->addChild(mustBe("symbol", "}"));
-
-    return result;
-}  
-
-/**
- * Generates a parse tree for a single class
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileClass() {
-
-    ParseTree* result = new ParseTree("class", "");
-
-    /* class Name {
-        ...
-    
-    */
-    result->addChild(mustBe("keyword", "class"));
-
-    if(current()->getType() == "identifier"){
-        result->addChild(current()); //Main, Bob, Apple
-    }
-    else{
-        throw ParseException();
+ParseTree* CompilerParser::compileClassParallel(ThreadPool& pool) {
+    if(lazy || symbols != nullptr || pool.size() < 2){
+        return compileClass();
     }
 
-    next();
-    result->addChild(mustBe("symbol", "{"));
-    
-    // class contents
-
-    // iterates over each variable declaration 
-    while(true){
-
-        // the class contains subroutines we must evaluate 
-        if(current()->getValue() == "static" 
-        || current()->getValue() == "field"){
-            
-            result->addChild(compileClassVarDec());
-        }
-        else{
-            break;
-        }
+    Token* const* start = cursor;
+    size_t errorCount = errors.size();
+    ParseTree* root;
+    lazy = true;
+    prescanning = true;
+    try{
+        root = compileClass();
     }
-
-    // iterates over each subroutine 
-    while(true){
-
-        // the class contains subroutines we must evaluate 
-        if(current()->getValue() == "function" 
-        || current()->getValue() == "method"
-        || current()->getValue() == "constructor"){
-
-            result->addChild(compileSubroutine());
-        }
-        else{
-            break;
-        }
+    catch(ParseException& e){
+        lazy = false;
+        prescanning = false;
+        throw;
     }
-
-    // class end }
-    result->addChild(mustBe("symbol", "}"));  
-
-    return result;
-}
-
-/**
- * Generates a parse tree for a static variable declaration or field declaration
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileClassVarDec() {
-    
-    ParseTree* result = new ParseTree("classVarDec", "");
-
-    //we have already established this is a either field or static
-    result->addChild(new Token("keyword", current()->getValue()));
-    next();
-    // type of variable
-    result->addChild(new Token("keyword", current()->getValue()));
-    next();
-
-    // iterating over each variable declaration
-    while(true){
-        if(current()->getType() == "identifier"){
-            result->addChild(current());
-            next();
-        }
-        else if(have("symbol", ",")){
-            result->addChild(current());
-            next();
-        }
-        else if(have("symbol", ";")){
-            result->addChild(current());
-            next();
-            break;
+    lazy = false;
+    prescanning = false;
+
+    // every subroutine whose body was skipped, and where the body starts
+    std::vector<ParseTree*> subroutines;
+    std::vector<size_t> starts;
+    for(ParseTree* child : root->getChildren()){
+        if(child->getKind() == NodeKind::Subroutine){
+            auto lazyBody = lazyBodies.find(child->getChildren().back());
+            if(lazyBody != lazyBodies.end()){
+                subroutines.push_back(child);
+                starts.push_back(lazyBody->second);
+                lazyBodies.erase(lazyBody);
+            }
         }
-        else{
-            throw ParseException();
-        }
-    }
-
-
-    return result;
-}
-
-
-
-/**
- * Generates a parse tree for a method, function, or constructor
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileSubroutine() {
-    
-    ParseTree* result = new ParseTree("subroutine", "");
-
-
-    //we have already established this is either constructor, function or method
-    result->addChild(new Token("keyword", current()->getValue()));
-    next();
-    
-    auto val = current()->getValue(); // either built in type (keyword), or className (identifier)
-    if(current()->getType() == "keyword" || current()->getType() == "identifier"){
-        result->addChild(current());
-    } 
-    else{
-        throw ParseException();
     }
 
-    next();
-
-
-    if(current()->getType() == "identifier"){
-        result->addChild(new Token("identifier", current()->getValue()));
-    } 
-    else{
-        throw ParseException();
+    // a few runs per thread, so threads that finish early can steal the rest
+    struct Run {
+        size_t begin;
+        size_t end;
+        std::vector<ParseTree*> bodies;
+        std::vector<ParseError> errors;
+        ParseResult tree;
+        bool exact = true;  // every body ended at its matching brace
+        bool failed = false;
+        std::exception_ptr error;   // anything else thrown, rethrown on this thread
+    };
+
+    // a worker may reserve what is left under the memory limit; all of them together are checked once they finish
+    Arena& arena = sink.getArena();
+    size_t limit = 0;
+    if(arena.getLimit() != 0){
+        limit = std::max<size_t>(arena.getLimit() - std::min(arena.getLimit(), arena.bytesReserved()), 1);
     }
 
-    
-
-    next();
-
-    // compiling parameters...
-    result->addChild(mustBe("symbol", "("));
-    result->addChild(compileParameterList());
-    result->addChild(mustBe("symbol", ")"));
-
-    // compiling inside of subroutine
-    result->addChild(compileSubroutineBody());
-
-    return result;
-
-}
-
-/**
- * Generates a parse tree for a subroutine's parameters
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileParameterList() {
-    ParseTree* result = new ParseTree("parameterList", "");
- 
-    if(have("symbol", ")")){
-        return result;
+    size_t runCount = std::min(subroutines.size(), pool.size() * 4);
+    std::vector<Run> runs(runCount);
+    for(size_t r = 0; r < runCount; r++){
+        Run& run = runs[r];
+        run.begin = subroutines.size() * r / runCount;
+        run.end = subroutines.size() * (r + 1) / runCount;
+        pool.submit([this, &run, &subroutines, &starts, limit]{
+            try{
+                CompilerParser worker(first, last);
+                worker.setMode(mode, maxDepth);
+                worker.setRecovery(recovering);
+                worker.sink.getArena().setLimit(limit);
+                try{
+                    for(size_t i = run.begin; i < run.end && run.exact; i++){
+                        worker.cursor = first + starts[i];
+                        ParseTree* body = worker.compileSubroutineBody();
+                        run.bodies.push_back(body);
+                        run.exact = body->getChildren().back() == subroutines[i]->getChildren().back()->getChildren().back();
+                    }
+                }
+                catch(ParseException& e){
+                    run.failed = true;
+                }
+                run.errors = std::move(worker.errors);
+                run.tree = worker.release(nullptr);
+            }
+            catch(...){
+                // ThreadPool tasks must not throw, e.g. std::bad_alloc from the memory limit
+                run.error = std::current_exception();
+            }
+        });
     }
+    pool.wait();
 
-
-    // iterate each parameter...
-    while(true){
-
-        // type of parameter, either built in type (keyword) or className (identifier)
-        if(current()->getType() == "keyword" || current()->getType() == "identifier"){
-            result->addChild(current());
-        } 
-        else{
-            throw ParseException();
-        }
-        next();
-
-        // name of parameter
-        if(current()->getType() == "identifier"){
-            result->addChild(current());
+    for(Run& run : runs){
+        if(run.error){
+            std::rethrow_exception(run.error);
         }
-        else{
+    }
+    for(Run& run : runs){
+        if(run.failed){
             throw ParseException();
         }
-
-        // (int a, int b)    
-
-        next();
-        if(!have("symbol", ",")){
-            break;
-        }
-        else{
-            // adding ','
-            result->addChild(current());
-            next();
+        if(!run.exact){
+            cursor = start;
+            errors.resize(errorCount);
+            return compileClass();
         }
     }
-    return result;
-}
-
-/**
- * Generates a parse tree for a subroutine's body
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileSubroutineBody() {
-
-    ParseTree* result = new ParseTree("subroutineBody", "");
 
-    result->addChild(mustBe("symbol", "{"));
-    
-    // iterating over each var declaration
-    while(true){
-        if(have("keyword", "var")){
-            result->addChild(compileVarDec());
+    if(limit != 0){
+        size_t reserved = arena.bytesReserved();
+        for(Run& run : runs){
+            reserved += run.tree.getArena()->bytesReserved();
         }
-        else{
-            break;
+        if(reserved > arena.getLimit()){
+            throw std::bad_alloc();
         }
     }
-    
-    // iterates over each statement
-    if(!have("symbol", "}")){
-        result->addChild(compileStatements());
-    }
-    result->addChild(mustBe("symbol", "}"));
-
-    return result;
-}
-
-/**
- * Generates a parse tree for a subroutine variable declaration
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileVarDec() {
-    
-    ParseTree* result = new ParseTree("varDec", "");
-
-    result->addChild(mustBe("keyword", "var"));
-
-    // type of var, either built in type (keyword) or className (identifier)
-    if(current()->getType() == "keyword" || current()->getType() == "identifier"){
-        result->addChild(current());
-        next();
-    } 
-    else{
-        throw ParseException();
-    }
 
-    // iterating over each variable declaration
-    while(true){
-        
-        if(current()->getType() == "identifier"){
-            result->addChild(current());
-            next();
-        }
-        else if(have("symbol", ",")){
-            result->addChild(current());
-            next();
-        }
-        else if(have("symbol", ";")){
-            result->addChild(current());
-            next();
-            break;
-        }
-        else{
-            throw ParseException();
+    for(Run& run : runs){
+        for(size_t i = run.begin; i < run.end; i++){
+            ParseTree* subroutine = subroutines[i];
+            subroutine->replaceChild(subroutine->getChildren().size() - 1, run.bodies[i - run.begin]);
         }
+        errors.insert(errors.end(), run.errors.begin(), run.errors.end());
+        arena.adopt(*run.tree.getArena());
     }
-
-    return result;
+    std::stable_sort(errors.begin() + errorCount, errors.end(), [](const ParseError& a, const ParseError& b){
+        return a.token < b.token;
+    });
+    return root;
 }
 
 /**
- * Generates a parse tree for a series of statements
- * @return a ParseTree
+ * Get the body of a subroutine, parsing it first if it was skipped in lazy
+ * mode. The placeholder is replaced in the tree, so the body is parsed once
+ * and later calls, or anyone walking the tree, see the parsed body.
+ *
+ * Bodies are only skipped outside recovery mode (see setLazy()), and the
+ * body is parsed the way the class was: it throws if it is not valid, even
+ * if recovery has been turned on since. So a valid body always ends at the
+ * brace that was matched when it was skipped, and no errors are added.
+ * @param subroutine A subroutine node returned by, or inside a tree returned by, this parser
+ * @return The subroutine's subroutineBody
+ * @throws ParseException if the body is not valid
  */
-ParseTree* CompilerParser::compileStatements() {
-
-    ParseTree* result = new ParseTree("statements", "");
-
-    // iterate over each statement
-    while(true){
-        if(have("keyword", "return")){
-            result->addChild(compileReturn());
-        }
-        else if(have("keyword", "let")){
-            result->addChild(compileLet());
-        }
-        else if(have("keyword", "if")){
-            result->addChild(compileIf());
-        }
-        else if(have("keyword", "while")){
-            result->addChild(compileWhile());
-        }
-        else if(have("keyword", "do")){
-            result->addChild(compileDo());
-        }
-        else{
-            break;
-        }
-        next();
+ParseTree* CompilerParser::expand(ParseTree* subroutine) {
+    ChildRange children = subroutine->getChildren();
+    auto lazyBody = lazyBodies.find(children.back());
+    if(lazyBody == lazyBodies.end()){
+        return children.back();
     }
 
-    return result;
-}
-
-/**
- * Generates a parse tree for a let statement
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileLet() {
-    return NULL;
-}
-
-/**
- * Generates a parse tree for an if statement
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileIf() {
-    
-    ParseTree* result = new ParseTree("ifStatement", "");
-
-    result->addChild(mustBe("keyword", "if"));
-    
-    result->addChild(compileExpression());
-
-    result->addChild(mustBe("symbol", "{"));
-    result->addChild(compileStatements());
-    result->addChild(mustBe("symbol", "}"));
-
-    if(have("keyword", "else")){
-        next();
-        result->addChild(mustBe("symbol", "{"));
-        result->addChild(compileStatements());
-        result->addChild(mustBe("symbol", "}"));
+    // the body is parsed on its own, outside the subroutine's scope, which has long been closed
+    Token* const* resume = cursor;
+    SymbolTable* table = symbols;
+    bool recovery = recovering;
+    cursor = first + lazyBody->second;
+    symbols = nullptr;
+    recovering = false;
+    ParseTree* body;
+    try{
+        body = compileSubroutineBody();
     }
+    catch(ParseException& e){
+        cursor = resume;
+        symbols = table;
+        recovering = recovery;
+        throw;
+    }
+    cursor = resume;
+    symbols = table;
+    recovering = recovery;
 
-    return result;
-}
-
-/**
- * Generates a parse tree for a while statement
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileWhile() {
-    
-    ParseTree* result = new ParseTree("whileStatement", "");
-
-    result->addChild(mustBe("keyword", "while"));
-    
-    result->addChild(compileExpression());
-
-    result->addChild(mustBe("symbol", "{"));
-    result->addChild(compileStatements());
-    result->addChild(mustBe("symbol", "}"));
-
-    return result;
-}
-/**
- * Generates a parse tree for a do statement
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileDo() {
-    
-    ParseTree* result = new ParseTree("doStatement", "");
-
-    result->addChild(mustBe("keyword", "do"));
-
-    result->addChild(compileExpression());
-
-    result->addChild(mustBe("symbol", ";"));
-    return result;
+    subroutine->replaceChild(children.size() - 1, body);
+    lazyBodies.erase(lazyBody);
+    return body;
 }
 
 /**
- * Generates a parse tree for a return statement
- * @return a ParseTree
+ * Expand every subroutine body in a tree that is still a placeholder.
+ * Placeholders are only made by compileSubroutine(), so the subroutines
+ * are either the root or children of a class node; nothing deeper is searched.
+ * @param root A tree returned by this parser
  */
-ParseTree* CompilerParser::compileReturn() {
-    
-    ParseTree* result = new ParseTree("returnStatement", "");
-
-    result->addChild(mustBe("keyword", "result"));
-
-    if(have("symbol", ";")){
-        result->addChild(current());
-        next();
-        return result;
+void CompilerParser::expandAll(ParseTree* root) {
+    if(root->getKind() == NodeKind::Subroutine){
+        expand(root);
     }
-    else {
-        result->addChild(compileExpression());
+    else if(root->getKind() == NodeKind::Class){
+        for(ParseTree* child : root->getChildren()){
+            if(child->getKind() == NodeKind::Subroutine){
+                expand(child);
+            }
+        }
     }
-    result->addChild(mustBe("symbol", ";"));
-
-    return result;
-
 }
 
 /**
- * Generates a parse tree for an expression
- * @return a ParseTree
+ * Hand over the nodes built so far. Trees returned by the compile methods are
+ * owned by the parser until they are released; afterwards the parser starts
+ * a fresh Arena for the next tree.
+ * @param root The tree to release, as returned by one of the compile methods
+ * @return A ParseResult that owns every node the parser allocated
  */
-ParseTree* CompilerParser::compileExpression() {
-    
-    ParseTree* result = new ParseTree("expression", "");
-
-    //check if the expression is just a term
-    if(have("keyword", "skip")) {
-        result->addChild(new Token("keyword", current()->getValue()));
-        next();
-        return result;
-    }
-
-    //check if there are more terms
-    while(have("symbol", "+") 
-        || have("symbol", "-") 
-        || have("symbol", "*") 
-        || have("symbol", "/") 
-        || have("symbol", "&") 
-        || have("symbol", "|") 
-        || have("symbol", "<") 
-        || have("symbol", ">") 
-        || have("symbol", "=")){
-
-        result->addChild(current());
-        next();
-        result->addChild(compileTerm());
-    }
-
-    next();
-    return result;
+ParseResult CompilerParser::release(ParseTree* root) {
+    lazyBodies.clear(); // bodies not expanded by now stay placeholders
+    return sink.release(root);
 }
 
 /**
- * Generates a parse tree for an expression term
- * @return a ParseTree
+ * Describe the error without its position
+ * @return e.g. "expected ';' but found identifier 'x'"
  */
-ParseTree* CompilerParser::compileTerm() {
-
-    ParseTree* result = new ParseTree("term", "");
-
-    auto type = current()->getType();
-
-    if(type == "stringConstant" || type == "keywordConstant" || type == "integerConstant"){
-        result->addChild(current());
-        next();
+std::string ParseError::message() const {
+    std::string text = "expected ";
+    if(expected != Atoms::Empty){
+        text += "'" + Interner::global().str(expected) + "'";
     }
-    else if(type == "identifier"){
-        result->addChild(current());
-
-        //check for array
-                
-        next();
-
-        if(have("symbol", "[")){
-
-            next();
-            result->addChild(compileExpression());
-            result->addChild(mustBe("symbol", "]"));
-        }
+    else if(expectedKind == NodeKind::Statements){
+        text += "a statement";
     }
-    // sub expression
-    else if(have("symbol", "(")){
-        result->addChild(current());
-        next();
-        result->addChild(compileExpression());
-        result->addChild(mustBe("symbol", ")"));
+    else if(expectedKind == NodeKind::Subroutine){
+        text += "a subroutine";
     }
-    else if(type == "unaryOp"){
-        result->addChild(current());
-        next();
-        if(current()->getType() == "term"){
-            result->addChild(compileTerm());
-        }
-        else{
-            throw ParseException();
-        }
+    else if(expectedKind == NodeKind::Keyword){
+        text += "a type";
     }
-
-
-
-    return result;
-
-}
-
-/**
- * Generates a parse tree for an expression list
- * @return a ParseTree
- */
-ParseTree* CompilerParser::compileExpressionList() {
-    return NULL;
-}
-
-/**
- * Advance to the next token
- */
-void CompilerParser::next(){
-    std::advance(tokenIterator, 1);
-    tokenCount++;
-    return;
-}
-
-/**
- * Return the current token
- * @return the Token
- */
-Token* CompilerParser::current(){
-    if(tokenCount >= tokens.size()){
-        throw ParseException();
+    else if(expectedKind == NodeKind::Eof){
+        text += "end of input";
     }
-    return *tokenIterator;
-}
-
-/**
- * Check if the current token matches the expected type and value.
- * @return true if a match, false otherwise
- */
-bool CompilerParser::have(std::string expectedType, std::string expectedValue){
-    auto token = current();
-
-    if(tokenCount >= tokens.size()){
-        // token out of bounds
-        throw ParseException();
-        return false;
+    else{
+        text += kindName(expectedKind);
     }
-    
-    if(token->getType() == expectedType && token->getValue() == expectedValue){
-        return true;
+
+    if(found->getKind() == NodeKind::Eof){
+        return text + " but found end of input";
     }
-    return false;
+    return text + " but found " + found->getType() + " '" + found->getValue() + "'";
 }
 
 /**
- * Check if the current token matches the expected type and value.
- * If so, advance to the next token, returning the current token, otherwise throw a ParseException.
- * @return the current token before advancing
+ * Describe the error with its line and column
+ * @param lines The line index of the text the parser's tokens were made from
+ * @return e.g. "3:14: expected ';' but found identifier 'x'"
  */
-Token* CompilerParser::mustBe(std::string expectedType, std::string expectedValue){
-    auto token = current();
-    
-    if(token->getType() == expectedType && token->getValue() == expectedValue){
-        next();
-        return token;
-    }
-    throw ParseException(); 
-    return nullptr;
+std::string ParseError::describe(const LineIndex& lines) const {
+    Location location = lines.locate(found->getSpan().offset);
+    return std::to_string(location.line) + ":" + std::to_string(location.column) + ": " + message();
 }
 
 /**
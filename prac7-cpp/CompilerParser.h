@@ -1,53 +1,28 @@
 #ifndef COMPILERPARSER_H
 #define COMPILERPARSER_H
 
-#include <list>
-#include <exception>
-
-#include "ParseTree.h"
-#include "Token.h"
-
-
-class CompilerParser {
+#include "BasicParser.h"
+#include "ParseResult.h"
+#include "ThreadPool.h"
+#include "TreeSink.h"
+
+/**
+ * The parser that builds ParseTrees. Trees returned by the compile methods
+ * are owned by the parser until they are released. In lazy mode (see
+ * setLazy()) subroutine bodies are parsed when expand() is first called on
+ * them, which must happen before the tree is released.
+ */
+class CompilerParser : public BasicParser<TreeSink> {
     public:
+        using BasicParser<TreeSink>::BasicParser;
 
-        int tokenCount;
-        std::list<Token*> tokens;
-        std::list<Token*>::iterator tokenIterator;
-
-
-        CompilerParser(std::list<Token*> tokens);
+        ParseTree* compileClassParallel(ThreadPool& pool);
 
-        ParseTree* compileProgram();
-        ParseTree* compileClass();
-        ParseTree* compileClassVarDec();
-        ParseTree* compileSubroutine();
-        ParseTree* compileParameterList();
-        ParseTree* compileSubroutineBody();
-        ParseTree* compileVarDec();
+        ParseTree* expand(ParseTree* subroutine);
 
-        ParseTree* compileStatements();
-        ParseTree* compileLet();
-        ParseTree* compileIf();
-        ParseTree* compileWhile();
-        ParseTree* compileDo();
-        ParseTree* compileReturn();
+        void expandAll(ParseTree* root);
 
-        ParseTree* compileExpression();
-        ParseTree* compileTerm();
-        ParseTree* compileExpressionList();
-
-        void printCurrent();
-        
-        void next();
-        Token* current();
-        bool have(std::string expectedType, std::string expectedValue);
-        Token* mustBe(std::string expectedType, std::string expectedValue);
-};
-
-class ParseException : public std::exception {
-    public:
-        const char* what();
+        ParseResult release(ParseTree* root);
 };
 
-#endif /*COMPILERPARSER_H*/
\ No newline at end of file
+#endif /*COMPILERPARSER_H*/
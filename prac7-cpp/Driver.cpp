@@ -0,0 +1,214 @@
+#include "Driver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+
+#include "CompilerParser.h"
+#include "FlatTree.h"
+#include "LineIndex.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "Tokenizer.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/**
+ * Constructor for a Driver
+ * @param threads The number of worker threads, 0 for one per hardware thread
+ */
+Driver::Driver(unsigned threads) {
+    Driver::threads = threads;
+    Driver::wallSeconds = 0;
+    Driver::cache = nullptr;
+    Driver::memoryLimit = 0;
+    Driver::mode = ParseMode::ExplicitStack;
+}
+
+/**
+ * Add a .jack file, or every .jack file directly inside a directory
+ * @param path The file or directory
+ */
+void Driver::addPath(const string& path) {
+    if (fs::is_directory(path)) {
+        for (const fs::directory_entry& entry : fs::directory_iterator(path)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".jack") {
+                paths.push_back(entry.path().string());
+            }
+        }
+    }
+    else {
+        paths.push_back(path);
+    }
+}
+
+/**
+ * Use a cache of parse trees from earlier runs
+ * @param cache The cache, which must outlive run(). nullptr to parse every file.
+ */
+void Driver::setCache(ParseCache* cache) {
+    Driver::cache = cache;
+}
+
+/**
+ * Cap the memory each file's parse tree may use
+ * @param bytes The most bytes one tree's Arena may reserve, 0 for no limit.
+ *              A file over the limit fails with an error.
+ */
+void Driver::setMemoryLimit(size_t bytes) {
+    Driver::memoryLimit = bytes;
+}
+
+/**
+ * Choose how each file is parsed
+ * @param mode ParseMode::Recursive is faster on shallow code, but deep
+ *             nesting can overflow a worker thread's stack
+ */
+void Driver::setMode(ParseMode mode) {
+    Driver::mode = mode;
+}
+
+/**
+ * Tokenize and parse one file, recording every error instead of throwing.
+ * A file with errors still gets the partial tree the parser recovered.
+ * @param result Where the path is read from and the outcome is written to
+ * @param cache Where to look for the tree first and store it after, or nullptr
+ * @param memoryLimit The most bytes the tree's Arena may reserve, 0 for no limit
+ * @param mode How the parser parses nested statements and expressions
+ */
+static void compileFile(FileResult& result, ParseCache* cache, size_t memoryLimit, ParseMode mode) {
+    auto start = chrono::steady_clock::now();
+    try {
+        MappedFile file(result.path);
+        result.bytes = file.size();
+
+        string key;
+        if (cache != nullptr) {
+            key = ParseCache::key(file.text());
+            result.cached = cache->load(key);
+            if (result.cached != nullptr) {
+                result.ok = true;
+                result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                return;
+            }
+        }
+
+        result.tokens = make_unique<TokenBuffer>(Tokenizer(file.text()).tokenize());
+        result.tokenCount = result.tokens->size();
+
+        CompilerParser parser(*result.tokens);
+        parser.setRecovery(true);
+        parser.setMode(mode);
+        parser.sink.getArena().setLimit(memoryLimit);
+        ParseTree* root = parser.compileClass();
+        if (parser.current()->getKind() != NodeKind::Eof) {
+            parser.fail(NodeKind::Eof); // tokens left over after the class
+        }
+        result.tree = parser.release(root);
+
+        if (!parser.getErrors().empty()) {
+            LineIndex lines(file.text());
+            for (const ParseError& error : parser.getErrors()) {
+                result.error += (result.error.empty() ? "" : "\n    ") + error.describe(lines);
+            }
+            result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            return;
+        }
+        result.ok = true;
+
+        if (cache != nullptr) {
+            cache->store(key, FlatTree(root));
+        }
+    } catch (ParseException& e) {
+        result.error = e.what();
+    } catch (bad_alloc& e) {
+        result.error = "parse tree over the memory limit";
+    } catch (exception& e) {
+        result.error = e.what();
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Compile every added file
+ * @return One FileResult per file, sorted by path
+ */
+vector<FileResult> Driver::run() {
+    sort(paths.begin(), paths.end());
+    paths.erase(unique(paths.begin(), paths.end()), paths.end());
+
+    vector<FileResult> results(paths.size());
+    vector<pair<uintmax_t, size_t>> bySize;
+    for (size_t i = 0; i < paths.size(); i++) {
+        results[i].path = paths[i];
+        error_code ignored;
+        uintmax_t size = fs::file_size(paths[i], ignored);
+        bySize.push_back({size == (uintmax_t) -1 ? 0 : size, i});
+    }
+    // biggest first, so the longest files are not left until the end
+    sort(bySize.begin(), bySize.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    auto start = chrono::steady_clock::now();
+    {
+        ThreadPool pool(threads);
+        for (const auto& file : bySize) {
+            FileResult* result = &results[file.second];
+            ParseCache* cache = this->cache;
+            size_t memoryLimit = this->memoryLimit;
+            ParseMode mode = this->mode;
+            pool.submit([result, cache, memoryLimit, mode] { compileFile(*result, cache, memoryLimit, mode); });
+        }
+        pool.wait();
+    }
+    if (cache != nullptr) {
+        cache->evict();
+    }
+    wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    return results;
+}
+
+/**
+ * Print per-file and total throughput of the last run()
+ * @param results The results returned by run()
+ * @param out Where to print
+ */
+void Driver::report(const vector<FileResult>& results, ostream& out) const {
+    size_t totalBytes = 0;
+    size_t totalTokens = 0;
+    double busySeconds = 0;
+    size_t failed = 0;
+    size_t cached = 0;
+
+    for (const FileResult& result : results) {
+        out << result.path << ": ";
+        if (result.cached != nullptr) {
+            out << result.bytes << " bytes, cached, " << result.seconds * 1000 << " ms\n";
+            cached++;
+        }
+        else if (result.ok) {
+            out << result.bytes << " bytes, " << result.tokenCount << " tokens, "
+                << result.seconds * 1000 << " ms, "
+                << (result.seconds > 0 ? result.bytes / result.seconds / 1e6 : 0) << " MB/s, "
+                << result.tree.getArena()->bytesReserved() / 1024 << " KB tree\n";
+        }
+        else {
+            out << "error: " << result.error << "\n";
+            failed++;
+        }
+        totalBytes += result.bytes;
+        totalTokens += result.tokenCount;
+        busySeconds += result.seconds;
+    }
+
+    out << results.size() << " files (" << failed << " failed, " << cached << " cached), "
+        << totalBytes << " bytes, " << totalTokens << " tokens in "
+        << wallSeconds * 1000 << " ms: "
+        << (wallSeconds > 0 ? totalBytes / wallSeconds / 1e6 : 0) << " MB/s, "
+        << (wallSeconds > 0 ? totalTokens / wallSeconds : 0) << " tokens/s, "
+        << "parallel speedup " << (wallSeconds > 0 ? busySeconds / wallSeconds : 0) << "\n";
+}
@@ -0,0 +1,71 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "BasicParser.h"
+#include "MappedTree.h"
+#include "ParseCache.h"
+#include "ParseResult.h"
+#include "TokenBuffer.h"
+
+/**
+ * The outcome of tokenizing and parsing one .jack file
+ */
+struct FileResult {
+    std::string path;
+    size_t bytes = 0;
+    size_t tokenCount = 0;
+    double seconds = 0;
+
+    bool ok = false;
+    std::string error;
+
+    // the tree's leaves point into tokens, so both are kept together
+    std::unique_ptr<TokenBuffer> tokens;
+    ParseResult tree;
+
+    // set instead of tokens and tree when the file was found in the ParseCache
+    std::unique_ptr<MappedTree> cached;
+};
+
+/**
+ * Compiles a Jack program (a directory of classes, one per .jack file)
+ * by running compileClass() on every file across a work-stealing ThreadPool.
+ * Files are scheduled largest first; results come back sorted by path.
+ * With a ParseCache, files whose text has been parsed before are not parsed again.
+ * Worker threads have small stacks, so files are parsed with an explicit
+ * stack unless setMode() says otherwise.
+ */
+class Driver {
+    private:
+        std::vector<std::string> paths;
+        unsigned threads;
+        double wallSeconds;
+        ParseCache* cache;
+        size_t memoryLimit;
+        ParseMode mode;
+
+    public:
+        Driver(unsigned threads = 0);
+
+        void addPath(const std::string& path);
+
+        // the .jack files added so far
+        const std::vector<std::string>& getPaths() const { return paths; }
+
+        void setCache(ParseCache* cache);
+
+        void setMemoryLimit(size_t bytes);
+
+        void setMode(ParseMode mode);
+
+        std::vector<FileResult> run();
+
+        void report(const std::vector<FileResult>& results, std::ostream& out) const;
+};
+
+#endif /*DRIVER_H*/
@@ -0,0 +1,86 @@
+#include "FlatTree.h"
+
+using namespace std;
+
+/**
+ * An empty FlatTree, to be filled with open(), close() and leaf()
+ */
+FlatTree::FlatTree() {
+
+}
+
+/**
+ * Flatten a ParseTree. Walks the tree with an explicit stack, so deep trees
+ * do not use native stack.
+ * @param root The tree to flatten
+ */
+FlatTree::FlatTree(const ParseTree* root) {
+    // each entry is a node whose children are still being copied, and the next child to copy
+    vector<pair<const ParseTree*, size_t>> stack;
+
+    open(root->getKind(), root->getAtom());
+    stack.push_back({root, 0});
+
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        ChildRange children = top.first->getChildren();
+        if (top.second == children.size()) {
+            close();
+            stack.pop_back();
+            continue;
+        }
+
+        const ParseTree* child = children[top.second++];
+        open(child->getKind(), child->getAtom());
+        stack.push_back({child, 0});
+    }
+}
+
+/**
+ * Start a node as the next child of the innermost open node
+ * @param kind The type of node
+ * @param value The node's value, Atoms::Empty for non-terminals
+ * @return The new node's id
+ */
+NodeId FlatTree::open(NodeKind kind, Atom value) {
+    NodeId node = (NodeId) kinds.size();
+    NodeId parent = openNodes.empty() ? NO_NODE : openNodes.back();
+
+    kinds.push_back(kind);
+    values.push_back(value);
+    parents.push_back(parent);
+    nextSiblings.push_back(NO_NODE);
+    ends.push_back(NO_NODE);
+
+    if (parent != NO_NODE) {
+        if (lastChildren.back() != NO_NODE) {
+            nextSiblings[lastChildren.back()] = node;
+        }
+        lastChildren.back() = node;
+    }
+
+    openNodes.push_back(node);
+    lastChildren.push_back(NO_NODE);
+    return node;
+}
+
+/**
+ * Finish the innermost open node
+ */
+void FlatTree::close() {
+    ends[openNodes.back()] = (NodeId) kinds.size();
+    openNodes.pop_back();
+    lastChildren.pop_back();
+}
+
+/**
+ * Add a node with no children, e.g. a token
+ * @param kind The type of node
+ * @param value The node's value
+ * @return The new node's id
+ */
+NodeId FlatTree::leaf(NodeKind kind, Atom value) {
+    NodeId node = open(kind, value);
+    close();
+    return node;
+}
@@ -0,0 +1,127 @@
+#ifndef FLATTREE_H
+#define FLATTREE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Interner.h"
+#include "NodeKind.h"
+#include "ParseTree.h"
+
+/**
+ * Index of a node in a FlatTree
+ */
+typedef uint32_t NodeId;
+
+const NodeId NO_NODE = UINT32_MAX;
+
+/**
+ * A parse tree stored as parallel arrays instead of linked nodes.
+ *
+ * Nodes are numbered in pre-order, so node 0 is the root, a node's first
+ * child (if any) is the node right after it, and its descendants are
+ * exactly the ids in [id + 1, end(id)). A whole-tree pass is a linear scan.
+ */
+class FlatTree {
+    private:
+        std::vector<NodeKind> kinds;
+        std::vector<Atom> values;
+        std::vector<NodeId> parents;
+        std::vector<NodeId> nextSiblings;
+        std::vector<NodeId> ends;
+
+        // nodes opened but not yet closed while building, and the last child of each
+        std::vector<NodeId> openNodes;
+        std::vector<NodeId> lastChildren;
+
+    public:
+        /**
+         * Iterates the children of one node by following sibling links
+         */
+        class ChildIterator {
+            private:
+                const NodeId* siblings;
+                NodeId node;
+
+            public:
+                ChildIterator(const NodeId* siblings, NodeId node) : siblings(siblings), node(node) {}
+
+                NodeId operator*() const { return node; }
+                ChildIterator& operator++() { node = siblings[node]; return *this; }
+                bool operator!=(const ChildIterator& other) const { return node != other.node; }
+        };
+
+        /**
+         * The children of one node, usable in a range-based for loop
+         */
+        class Children {
+            private:
+                const NodeId* siblings;
+                NodeId first;
+
+            public:
+                Children(const NodeId* siblings, NodeId first) : siblings(siblings), first(first) {}
+
+                ChildIterator begin() const { return ChildIterator(siblings, first); }
+                ChildIterator end() const { return ChildIterator(siblings, NO_NODE); }
+        };
+
+        FlatTree();
+        FlatTree(const ParseTree* root);
+
+        NodeId open(NodeKind kind, Atom value = Atoms::Empty);
+        void close();
+        NodeId leaf(NodeKind kind, Atom value);
+
+        size_t size() const { return kinds.size(); }
+
+        NodeKind kind(NodeId node) const { return kinds[node]; }
+        Atom value(NodeId node) const { return values[node]; }
+        NodeId parent(NodeId node) const { return parents[node]; }
+        NodeId nextSibling(NodeId node) const { return nextSiblings[node]; }
+        NodeId end(NodeId node) const { return ends[node]; }
+
+        NodeId firstChild(NodeId node) const {
+            return ends[node] > node + 1 ? node + 1 : NO_NODE;
+        }
+
+        Children children(NodeId node) const {
+            return Children(nextSiblings.data(), firstChild(node));
+        }
+
+        /**
+         * Visit every node of a subtree in pre-order (parents before children)
+         * @param root The subtree to visit
+         * @param visit Called with each NodeId
+         */
+        template <class Visitor>
+        void preorder(NodeId root, Visitor&& visit) const {
+            for (NodeId node = root; node < ends[root]; node++) {
+                visit(node);
+            }
+        }
+
+        /**
+         * Visit every node of a subtree in post-order (children before parents).
+         * Uses a stack as deep as the tree rather than recursion.
+         * @param root The subtree to visit
+         * @param visit Called with each NodeId
+         */
+        template <class Visitor>
+        void postorder(NodeId root, Visitor&& visit) const {
+            std::vector<NodeId> open;
+            for (NodeId node = root; node < ends[root]; node++) {
+                while (!open.empty() && ends[open.back()] <= node) {
+                    visit(open.back());
+                    open.pop_back();
+                }
+                open.push_back(node);
+            }
+            while (!open.empty()) {
+                visit(open.back());
+                open.pop_back();
+            }
+        }
+};
+
+#endif /*FLATTREE_H*/
@@ -0,0 +1,144 @@
+#include "HashConsSink.h"
+
+#include <algorithm>
+
+#include "BasicParser.tpp"
+
+template class BasicParser<HashConsSink>;
+
+using namespace std;
+
+/**
+ * Mix a hash with one more word
+ */
+static uint64_t combine(uint64_t hash, uint64_t word) {
+    hash ^= word + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+/**
+ * A sink with an empty Arena and an empty table
+ */
+HashConsSink::HashConsSink() {
+    this->arena = make_unique<Arena>();
+    this->slots.assign(1024, Slot{0, nullptr});
+    this->count = 0;
+    this->lastLeft = nullptr;
+}
+
+/**
+ * Find the node with this kind, value and children, making it if there is none
+ * @param kind The type of node
+ * @param value The node's value, Atoms::Empty for non-terminals
+ * @param first The first of its children, which are already distinct nodes
+ * @param last Just past its last child
+ * @param leaf true to make a Token, false for a ParseTree
+ * @return The one node with this structure
+ */
+ParseTree* HashConsSink::intern(NodeKind kind, Atom value, ParseTree* const* first, ParseTree* const* last, bool leaf) {
+    uint64_t hash = combine((uint64_t) kind, value);
+    for (ParseTree* const* child = first; child != last; child++) {
+        hash = combine(hash, (uint64_t) (uintptr_t) *child);
+    }
+
+    size_t mask = slots.size() - 1;
+    size_t slot = (size_t) hash & mask;
+    size_t size = (size_t) (last - first);
+    while (slots[slot].node != nullptr) {
+        ParseTree* node = slots[slot].node;
+        if (slots[slot].hash == hash && node->getKind() == kind && node->getAtom() == value) {
+            ChildRange existing = node->getChildren();
+            if (existing.size() == size && equal(first, last, existing.begin())) {
+                return node;
+            }
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    ParseTree* node;
+    if (leaf) {
+        node = arena->make<Token>(kind, value, arena.get());
+    }
+    else {
+        node = arena->make<ParseTree>(kind, value, arena.get());
+        node->reserveChildren(size);
+        for (ParseTree* const* child = first; child != last; child++) {
+            node->addChild(*child);
+        }
+    }
+    slots[slot] = Slot{hash, node};
+    if (++count * 2 > slots.size()) {
+        grow();
+    }
+    return node;
+}
+
+/**
+ * Double the table
+ */
+void HashConsSink::grow() {
+    vector<Slot> old(slots.size() * 2, Slot{0, nullptr});
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const Slot& entry : old) {
+        if (entry.node == nullptr) {
+            continue;
+        }
+        size_t slot = (size_t) entry.hash & mask;
+        while (slots[slot].node != nullptr) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = entry;
+    }
+}
+
+/**
+ * Start a node around children that have already been built, which become
+ * its first children
+ * @param mark The position returned by mark() before the first of those children
+ * @param kind The type of node
+ */
+void HashConsSink::wrap(size_t mark, NodeKind kind) {
+    if (openNodes.empty()) {
+        // the parser was called directly, outside any other production
+        children.push_back(lastLeft);
+        openNodes.push_back({kind, children.size() - 1});
+    }
+    else {
+        openNodes.push_back({kind, openNodes.back().start + mark});
+    }
+}
+
+/**
+ * Finish the innermost node: find or make the one node with its children,
+ * and add that to its parent
+ * @return The finished node
+ */
+ParseTree* HashConsSink::leave() {
+    Frame frame = openNodes.back();
+    openNodes.pop_back();
+    ParseTree* node = intern(frame.kind, Atoms::Empty, children.data() + frame.start,
+                             children.data() + children.size(), false);
+    children.resize(frame.start);
+    if (!openNodes.empty()) {
+        children.push_back(node);
+    }
+    lastLeft = node;
+    return node;
+}
+
+/**
+ * Hand over the nodes built so far, and start a fresh Arena and table for
+ * the next tree. Nodes of the next tree are never shared with this one.
+ * @param root The tree to release, as returned by one of the compile methods
+ * @return A ParseResult that owns every node the sink allocated
+ */
+ParseResult HashConsSink::release(ParseTree* root) {
+    ParseResult result(move(arena), root);
+    arena = make_unique<Arena>();
+    slots.assign(1024, Slot{0, nullptr});
+    count = 0;
+    openNodes.clear(); // left behind if a ParseException stopped a compile method
+    children.clear();
+    return result;
+}
@@ -0,0 +1,88 @@
+#ifndef HASHCONSSINK_H
+#define HASHCONSSINK_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Arena.h"
+#include "ParseResult.h"
+#include "ParseTree.h"
+#include "Token.h"
+
+/**
+ * The BasicParser Sink that builds a parse tree in which structurally
+ * identical subtrees are one node (hash-consing). Every leaf with the same
+ * kind and value is one Token, and every node with the same kind and the
+ * same children is one ParseTree, found through a table keyed on a hash of
+ * the kind and the child pointers. Repeated expressions, terms, types and
+ * names, which generated code is full of, are stored once.
+ *
+ * Because children are shared before their parent is made, two subtrees
+ * built by the same sink (between releases) are equal exactly when they
+ * are the same pointer, which makes comparing them O(1).
+ *
+ * The result is a DAG: nodes must not be changed (see replaceChild()), and
+ * a leaf stands for every occurrence of its token, so it carries no position
+ * in the input. Leaves are the sink's own tokens, so the tree does not point
+ * into the parser's input, which may be freed once the parse is done.
+ */
+class HashConsSink {
+    private:
+        // one slot of the table of distinct nodes, node is nullptr in an empty slot
+        struct Slot {
+            uint64_t hash;
+            ParseTree* node;
+        };
+
+        // a node started by enter() or wrap(), whose children are children[start..]
+        struct Frame {
+            NodeKind kind;
+            size_t start;
+        };
+
+        std::unique_ptr<Arena> arena;
+
+        // open addressing, a power of two in size, at most half full
+        std::vector<Slot> slots;
+        size_t count;
+
+        // the children of every open node, innermost node's last
+        std::vector<Frame> openNodes;
+        std::vector<ParseTree*> children;
+        ParseTree* lastLeft;
+
+        ParseTree* intern(NodeKind kind, Atom value, ParseTree* const* first, ParseTree* const* last, bool leaf);
+        void grow();
+
+    public:
+        HashConsSink();
+
+        void enter(NodeKind kind) { openNodes.push_back({kind, children.size()}); }
+
+        // the leaf standing for every token with this token's kind and value
+        void token(Token* token) { children.push_back(makeToken(token->getKind(), token->getAtom())); }
+
+        Token* makeToken(NodeKind kind, Atom value) {
+            return static_cast<Token*>(intern(kind, value, nullptr, nullptr, true));
+        }
+
+        // the position the next child of the innermost node will have
+        size_t mark() const {
+            return openNodes.empty() ? 0 : children.size() - openNodes.back().start;
+        }
+
+        void wrap(size_t mark, NodeKind kind);
+
+        ParseTree* leave();
+
+        // the Arena the distinct nodes are in
+        Arena& getArena() { return *arena; }
+
+        // how many distinct nodes and leaves have been made
+        size_t distinct() const { return count; }
+
+        ParseResult release(ParseTree* root);
+};
+
+#endif /*HASHCONSSINK_H*/
@@ -0,0 +1,183 @@
+#include "IncrementalParser.h"
+
+#include <algorithm>
+
+#include "CompilerParser.h"
+#include "Token.h"
+#include "Tokenizer.h"
+
+using namespace std;
+
+/**
+ * Constructor for an IncrementalParser. Parses the whole class.
+ * @param source The text of one .jack file
+ * @throws ParseException if the source is not a valid class
+ */
+IncrementalParser::IncrementalParser(string source) {
+    this->source = move(source);
+    parseAll();
+}
+
+/**
+ * Parse the whole class, and find where each subroutine's text is
+ * @throws ParseException if the source is not a valid class
+ */
+void IncrementalParser::parseAll() {
+    segments.clear();
+    children.clear();
+    tree = ParseResult();
+
+    tokens = make_unique<TokenBuffer>(Tokenizer(source).tokenize());
+    CompilerParser parser(*tokens);
+    tree = parser.release(parser.compileClass());
+
+    auto before = [](const Token* token, uint32_t offset) {
+        return token->getSpan().offset < offset;
+    };
+    ChildRange nodes = tree.getRoot()->getChildren();
+    for (size_t child = 0; child < nodes.size(); child++) {
+        // the child's tokens are the run of the buffer inside its span
+        Span span = nodes[child]->span();
+        Token* const* first = tokens->begin();
+        Token* const* last = first;
+        if (span.known()) {
+            first = lower_bound(tokens->begin(), tokens->end(), span.offset, before);
+            last = lower_bound(first, tokens->end(), span.end(), before);
+        }
+        children.push_back(Child{first, last, 0});
+
+        if (nodes[child]->getKind() == NodeKind::Subroutine) {
+            segments.push_back(Segment{span.offset, span.end(), child, nullptr, ParseResult()});
+        }
+    }
+}
+
+/**
+ * Reparse one subroutine after its text has changed, and splice it into the tree
+ * @param segment The subroutine, with its old position in the source
+ * @param end The new offset just past its closing brace
+ * @return true on success, false if the subroutine does not parse on its own
+ */
+bool IncrementalParser::reparse(Segment& segment, uint32_t end) {
+    string_view text = string_view(source).substr(segment.begin, end - segment.begin);
+    unique_ptr<TokenBuffer> newTokens;
+    ParseResult newTree;
+
+    try {
+        newTokens = make_unique<TokenBuffer>(Tokenizer(text).tokenize());
+        CompilerParser parser(*newTokens);
+        if (!(parser.have(NodeKind::Keyword, Atoms::Function)
+              || parser.have(NodeKind::Keyword, Atoms::Method)
+              || parser.have(NodeKind::Keyword, Atoms::Constructor))) {
+            return false;
+        }
+        newTree = parser.release(parser.compileSubroutine());
+        if (parser.current()->getKind() != NodeKind::Eof) {
+            return false;
+        }
+    } catch (ParseException& e) {
+        return false;
+    }
+
+    // the closing brace must still be a token of its own; if it was swallowed
+    // by a comment or string, lexing the whole file could read past it
+    const Token* closing = (*newTokens)[newTokens->size() - 1];
+    if (closing->getSpan().offset != text.size() - 1) {
+        return false;
+    }
+
+    // the new tokens were found in the subroutine's text; make their spans offsets in the whole source
+    for (Token* const* token = newTokens->begin(); token != newTokens->end(); token++) {
+        Span span = (*token)->getSpan();
+        (*token)->setSpan(Span{span.offset + segment.begin, span.length});
+    }
+
+    tree.getRoot()->replaceChild(segment.child, newTree.getRoot());
+    children[segment.child] = Child{newTokens->begin(), newTokens->end(), 0};
+    segment.end = end;
+    segment.tokens = move(newTokens);
+    segment.tree = move(newTree);
+    return true;
+}
+
+/**
+ * Replace part of the source and bring the tree up to date
+ * @param offset Where the replaced text starts
+ * @param length How many bytes to replace
+ * @param text The text to put in their place
+ * @return true if only one subroutine was reparsed, false if the whole class was
+ * @throws ParseException if the edited source is not a valid class. The
+ *         edit is kept, getRoot() returns nullptr until a later edit fixes it.
+ */
+bool IncrementalParser::edit(size_t offset, size_t length, string_view text) {
+    source.replace(offset, length, text);
+    int64_t delta = (int64_t) text.size() - (int64_t) length;
+
+    // the last subroutine starting before the edit
+    auto after = upper_bound(segments.begin(), segments.end(), offset,
+                             [](size_t position, const Segment& segment) {
+                                 return position < segment.begin;
+                             });
+
+    // spans cannot hold offsets of 4 GB or more, so a source that big is always parsed whole
+    if (after != segments.begin() && tree.getRoot() != nullptr && source.size() < Span::UNKNOWN) {
+        Segment& segment = *(after - 1);
+
+        // the edit may not touch the first token's start or the closing brace
+        if (offset > segment.begin && offset + length < segment.end
+            && reparse(segment, (uint32_t) (segment.end + delta))) {
+            for (; after != segments.end(); ++after) {
+                after->begin += delta;
+                after->end += delta;
+            }
+            // everything after the subroutine moved, including the class's closing brace
+            for (size_t child = segment.child + 1; child < children.size(); child++) {
+                children[child].shift += delta;
+            }
+            return true;
+        }
+    }
+
+    parseAll();
+    return false;
+}
+
+/**
+ * Find how far a token's span is behind the source
+ * @param token A token in the tree
+ * @return The bytes to add to its span, 0 if its child of the class has not moved
+ */
+int64_t IncrementalParser::shiftOf(const Token* token) const {
+    uint32_t offset = token->getSpan().offset;
+    for (const Child& child : children) {
+        if (child.shift == 0) {
+            continue;
+        }
+        Token* const* found = lower_bound(child.first, child.last, offset,
+                                          [](const Token* candidate, uint32_t position) {
+                                              return candidate->getSpan().offset < position;
+                                          });
+        if (found != child.last && *found == token) {
+            return child.shift;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Find where a node of the tree is in the current source. The node's edge
+ * tokens are looked up among the class's moved children, so the cost does
+ * not depend on how many tokens have moved.
+ * @param node A node of the tree from getRoot()
+ * @return The span, unknown if no token in the node came from the input
+ */
+Span IncrementalParser::span(const ParseTree* node) const {
+    const Token* first = node->edgeToken(true);
+    if (first == nullptr) {
+        return Span();
+    }
+    const Token* last = node->edgeToken(false);
+    uint32_t begin = (uint32_t) (first->getSpan().offset + shiftOf(first));
+    uint32_t end = (uint32_t) (last->getSpan().end() + shiftOf(last));
+    return Span{begin, end - begin};
+}
@@ -0,0 +1,76 @@
+#ifndef INCREMENTALPARSER_H
+#define INCREMENTALPARSER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ParseResult.h"
+#include "ParseTree.h"
+#include "TokenBuffer.h"
+
+/**
+ * Keeps the parse tree of one class up to date while its source is edited.
+ *
+ * An edit that falls strictly inside one subroutine relexes and reparses
+ * just that subroutine with compileSubroutine() and splices the new subtree
+ * into the class node, so the cost depends on the size of the subroutine,
+ * not of the class. Any other edit, or one that leaves the subroutine
+ * unable to stand on its own, falls back to parsing the whole class.
+ * An edit only notes how far the class's later children moved; their
+ * tokens keep the spans they were made with. Read spans of nodes in the
+ * tree through span(), which adds the move, to get offsets in the current
+ * source.
+ */
+class IncrementalParser {
+    private:
+        // one subroutine of the class, and where its text is in the source
+        struct Segment {
+            uint32_t begin;   // offset of its first token
+            uint32_t end;     // offset just past its closing brace
+            size_t child;     // its position among the class node's children
+
+            // set once the subroutine has been reparsed on its own
+            std::unique_ptr<TokenBuffer> tokens;
+            ParseResult tree;
+        };
+
+        std::string source;
+
+        // the last full parse, which unchanged subroutines still point into
+        std::unique_ptr<TokenBuffer> tokens;
+        ParseResult tree;
+
+        // ordered by position in the source
+        std::vector<Segment> segments;
+
+        // the tokens of one child of the class node, and how far their spans are behind the source
+        struct Child {
+            Token* const* first;   // in source order, in the TokenBuffer that holds them
+            Token* const* last;
+            int64_t shift;
+        };
+
+        // one per child of the class node
+        std::vector<Child> children;
+
+        void parseAll();
+        bool reparse(Segment& segment, uint32_t end);
+        int64_t shiftOf(const Token* token) const;
+
+    public:
+        IncrementalParser(std::string source);
+
+        bool edit(size_t offset, size_t length, std::string_view text);
+
+        // the class node, or nullptr if the last edit left a source that does not parse
+        ParseTree* getRoot() const { return tree.getRoot(); }
+
+        Span span(const ParseTree* node) const;
+
+        const std::string& getSource() const { return source; }
+};
+
+#endif /*INCREMENTALPARSER_H*/
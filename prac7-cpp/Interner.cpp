@@ -0,0 +1,208 @@
+#include "Interner.h"
+
+#include <cstring>
+#include <mutex>
+
+using namespace std;
+
+/**
+ * Constructor for an Interner
+ * @param seeds Strings to intern up front, given ids 0, 1, 2... in order
+ */
+Interner::Interner(initializer_list<const char*> seeds) {
+    for (int chunk = 0; chunk < CHUNK_COUNT; chunk++) {
+        chunks[chunk].store(nullptr, memory_order_relaxed);
+    }
+    count = 0;
+    slots.assign(64, 0);
+
+    for (const char* seed : seeds) {
+        intern(seed);
+    }
+}
+
+/**
+ * Frees every interned string
+ */
+Interner::~Interner() {
+    for (int chunk = 0; chunk < CHUNK_COUNT; chunk++) {
+        delete[] chunks[chunk].load(memory_order_relaxed);
+    }
+}
+
+/**
+ * Hash a string, 8 bytes at a time
+ * @param text The string to hash
+ * @return A 32-bit hash of text
+ */
+uint32_t Interner::hash(string_view text) {
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t h = text.size() * multiplier;
+    const char* bytes = text.data();
+    size_t left = text.size();
+
+    while (left >= 8) {
+        uint64_t chunk;
+        memcpy(&chunk, bytes, 8);
+        h = (h ^ chunk) * multiplier;
+        h ^= h >> 29;
+        bytes += 8;
+        left -= 8;
+    }
+    if (left > 0) {
+        uint64_t chunk = 0;
+        memcpy(&chunk, bytes, left);
+        h = (h ^ chunk) * multiplier;
+        h ^= h >> 29;
+    }
+    return (uint32_t) (h ^ (h >> 32));
+}
+
+/**
+ * Find the storage of an atom's string
+ * @param atom An atom returned by this Interner
+ * @return The stored string
+ */
+string& Interner::entry(Atom atom) const {
+    uint32_t index = atom + FIRST_CHUNK;
+    int chunk = (31 - __builtin_clz(index)) - 6;
+    return chunks[chunk].load(memory_order_acquire)[index - (FIRST_CHUNK << chunk)];
+}
+
+/**
+ * Probe the slot table. The caller must hold the lock.
+ * @param text The string to look for
+ * @param h The hash of text
+ * @param atom Set to the string's atom if it was found
+ * @return true if text has been interned, false otherwise
+ */
+bool Interner::lookup(string_view text, uint32_t h, Atom& atom) const {
+    size_t mask = slots.size() - 1;
+
+    for (size_t slot = h & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+        Atom candidate = slots[slot] - 1;
+        if (hashes[candidate] == h && entry(candidate) == text) {
+            atom = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Add a string that is not in the table yet. The caller must hold the lock exclusively.
+ * @param text The string to add
+ * @param h The hash of text
+ * @return The new atom
+ */
+Atom Interner::insert(string_view text, uint32_t h) {
+    Atom atom = (Atom) count;
+    uint32_t index = atom + FIRST_CHUNK;
+    int chunk = (31 - __builtin_clz(index)) - 6;
+    if (chunks[chunk].load(memory_order_relaxed) == nullptr) {
+        chunks[chunk].store(new string[FIRST_CHUNK << chunk], memory_order_release);
+    }
+    entry(atom) = string(text);
+    hashes.push_back(h);
+    count++;
+
+    size_t mask = slots.size() - 1;
+    size_t slot = h & mask;
+    while (slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    slots[slot] = atom + 1;
+
+    // keep the table at most half full
+    if (count * 2 > slots.size()) {
+        grow();
+    }
+    return atom;
+}
+
+/**
+ * Get the atom for a string, adding it to the table if it is new.
+ * Looking up a string that is already interned does not allocate.
+ * @param text The string to intern
+ * @return The atom for text
+ */
+Atom Interner::intern(string_view text) {
+    uint32_t h = hash(text);
+    Atom atom;
+    {
+        shared_lock<shared_mutex> reading(lock);
+        if (lookup(text, h, atom)) {
+            return atom;
+        }
+    }
+
+    unique_lock<shared_mutex> writing(lock);
+    // another thread may have added it since the shared lock was released
+    if (lookup(text, h, atom)) {
+        return atom;
+    }
+    return insert(text, h);
+}
+
+/**
+ * Look up a string without adding it to the table
+ * @param text The string to look for
+ * @param atom Set to the string's atom if it was found
+ * @return true if text has been interned, false otherwise
+ */
+bool Interner::find(string_view text, Atom& atom) const {
+    shared_lock<shared_mutex> reading(lock);
+    return lookup(text, hash(text), atom);
+}
+
+/**
+ * Double the size of the slot table and reinsert every atom
+ */
+void Interner::grow() {
+    slots.assign(slots.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+
+    for (Atom atom = 0; atom < (Atom) hashes.size(); atom++) {
+        size_t slot = hashes[atom] & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = atom + 1;
+    }
+}
+
+/**
+ * Get the string an atom was made from. Takes no lock: the atom itself
+ * can only have been obtained after its string was stored.
+ * @param atom An atom returned by this Interner
+ * @return The interned string
+ */
+const string& Interner::str(Atom atom) const {
+    return entry(atom);
+}
+
+/**
+ * Get the number of distinct strings interned so far
+ * @return The size of the table
+ */
+size_t Interner::size() const {
+    shared_lock<shared_mutex> reading(lock);
+    return count;
+}
+
+/**
+ * The table shared by all tokens and parse trees for their values.
+ * The predefined atoms in Atoms are seeded in the same order they are declared.
+ * @return The global Interner
+ */
+Interner& Interner::global() {
+    static Interner interner({
+        "class", "constructor", "function", "method", "field", "static", "var",
+        "int", "char", "boolean", "void", "true", "false", "null", "this",
+        "let", "do", "if", "else", "while", "return",
+        "{", "}", "(", ")", "[", "]", ".", ",", ";",
+        "+", "-", "*", "/", "&", "|", "<", ">", "=", "~",
+        ""
+    });
+    return interner;
+}
@@ -0,0 +1,92 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * An interned string. Two atoms from the same Interner are equal
+ * exactly when the strings they were made from are equal.
+ */
+typedef uint32_t Atom;
+
+/**
+ * Atoms that are interned ahead of time, so the parser can compare
+ * keywords and symbols against constants instead of strings.
+ * Keywords come first so an atom below KeywordCount is a keyword.
+ */
+namespace Atoms {
+    enum : Atom {
+        // keywords
+        Class, Constructor, Function, Method, Field, Static, Var,
+        Int, Char, Boolean, Void, True, False, Null, This,
+        Let, Do, If, Else, While, Return,
+        KeywordCount,
+
+        // symbols
+        LeftBrace = KeywordCount, RightBrace, LeftParen, RightParen,
+        LeftBracket, RightBracket, Dot, Comma, Semicolon,
+        Plus, Minus, Star, Slash, Ampersand, Pipe,
+        LessThan, GreaterThan, Equals, Tilde,
+
+        // the empty value carried by non-terminal nodes
+        Empty,
+
+        Count
+    };
+}
+
+/**
+ * A table mapping strings to small integer ids and back.
+ * Stored strings never move, so references returned by str() stay valid
+ * for the lifetime of the Interner.
+ *
+ * Safe to share between threads: lookups take a shared lock, adding a new
+ * string takes an exclusive one, and str() takes no lock at all.
+ */
+class Interner {
+    private:
+        // strings live in chunks that are never moved; chunk k holds FIRST_CHUNK << k strings
+        static const int CHUNK_COUNT = 26;
+        static const uint32_t FIRST_CHUNK = 64;
+        std::atomic<std::string*> chunks[CHUNK_COUNT];
+
+        size_t count;
+        std::vector<uint32_t> hashes;
+
+        // open addressing table of atom + 1, 0 for an empty slot
+        std::vector<Atom> slots;
+
+        mutable std::shared_mutex lock;
+
+        std::string& entry(Atom atom) const;
+        bool lookup(std::string_view text, uint32_t h, Atom& atom) const;
+        Atom insert(std::string_view text, uint32_t h);
+        void grow();
+
+    public:
+        Interner(std::initializer_list<const char*> seeds = {});
+        ~Interner();
+
+        Interner(const Interner&) = delete;
+        Interner& operator=(const Interner&) = delete;
+
+        Atom intern(std::string_view text);
+
+        bool find(std::string_view text, Atom& atom) const;
+
+        const std::string& str(Atom atom) const;
+
+        size_t size() const;
+
+        static uint32_t hash(std::string_view text);
+
+        static Interner& global();
+};
+
+#endif /*INTERNER_H*/
@@ -0,0 +1,41 @@
+#include "LineIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ParseTree.h"
+
+using namespace std;
+
+/**
+ * Constructor for a LineIndex. Nothing is read until a location is asked for.
+ * @param source The text of the file, which must outlive the index
+ */
+LineIndex::LineIndex(string_view source) {
+    this->source = source;
+}
+
+/**
+ * Find the line and column of a byte offset
+ * @param offset A byte offset in the source, e.g. Span::offset. Span::UNKNOWN,
+ *               which tokens past 4 GB also have, and offsets past the end
+ *               are taken as the end.
+ * @return Its line and column
+ */
+Location LineIndex::locate(uint32_t offset) const {
+    call_once(built, [this] {
+        lineStarts.push_back(0);
+        const char* text = source.data();
+        const char* end = text + source.size();
+        for (const char* newline = text;
+             (newline = (const char*) memchr(newline, '\n', (size_t) (end - newline))) != nullptr;
+             newline++) {
+            lineStarts.push_back((size_t) (newline + 1 - text));
+        }
+    });
+
+    size_t position = offset == Span::UNKNOWN ? source.size() : min((size_t) offset, source.size());
+    // the last line starting at or before the position
+    size_t line = (size_t) (upper_bound(lineStarts.begin(), lineStarts.end(), position) - lineStarts.begin());
+    return Location{line, position - lineStarts[line - 1] + 1};
+}
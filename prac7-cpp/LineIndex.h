@@ -0,0 +1,39 @@
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+/**
+ * A line and column in a source file, both counted from 1. The column is
+ * in bytes. Both are size_t, as files may be larger than 4 GB.
+ */
+struct Location {
+    size_t line;
+    size_t column;
+};
+
+/**
+ * Turns byte offsets in one source file (see Span) into lines and columns.
+ *
+ * The offset of each line start is found on the first call to locate(),
+ * so files whose locations are never asked for cost nothing. After that,
+ * each lookup is a binary search. Safe to share between threads.
+ */
+class LineIndex {
+    private:
+        std::string_view source;
+
+        mutable std::once_flag built;
+        mutable std::vector<size_t> lineStarts;
+
+    public:
+        LineIndex(std::string_view source);
+
+        Location locate(uint32_t offset) const;
+};
+
+#endif /*LINEINDEX_H*/
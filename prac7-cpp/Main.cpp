@@ -1,30 +1,285 @@
+#include <filesystem>
+#include <fstream>
 #include <iostream>
-#include <list>
+#include <memory>
+#include <stdexcept>
+#include <vector>
 
+#include "CodeGenerator.h"
 #include "CompilerParser.h"
+#include "Driver.h"
+#include "FlatTree.h"
+#include "HashConsSink.h"
+#include "LineIndex.h"
+#include "MappedFile.h"
+#include "MemoryReport.h"
+#include "OutputBuffer.h"
+#include "ParseCache.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
 #include "Token.h"
+#include "TokenBuffer.h"
+#include "Tokenizer.h"
+#include "TreeWriter.h"
 
 using namespace std;
 
+/**
+ * Write what the Profiler recorded, if a file name prefix was given
+ */
+static void writeProfile(const string& prefix) {
+    if (prefix.empty()) {
+        return;
+    }
+    ofstream json(prefix + ".json");
+    Profiler::writeJson(json);
+    ofstream trace(prefix + ".trace.json");
+    Profiler::writeTrace(trace);
+}
+
+/**
+ * Compile one .jack file to Hack VM code in a single pass, reporting every error in it
+ * @param path The .jack file
+ * @param outputPath Where to write the code, "" for standard output
+ * @param mode How nested statements and expressions are parsed
+ * @return true if the file compiled
+ */
+static bool compileVm(const string& path, const string& outputPath, ParseMode mode) {
+    MappedFile file(path);
+    TokenBuffer tokens = Tokenizer(file.text()).tokenize();
+
+    // nothing is written until the whole file is known to be good
+    string code;
+    {
+        OutputBuffer out(code);
+        SymbolTable symbols;
+        BasicParser<CodeGenerator> parser(tokens, CodeGenerator(out, symbols));
+        parser.setRecovery(true);
+        parser.setMode(mode);
+        parser.setSymbols(&symbols);
+        parser.compileClass();
+        if (parser.current()->getKind() != NodeKind::Eof) {
+            parser.fail(NodeKind::Eof);
+        }
+
+        LineIndex lines(file.text());
+        for (const ParseError& error : parser.getErrors()) {
+            cerr << path << ":" << error.describe(lines) << "\n";
+        }
+        for (const string& error : parser.sink.getErrors()) {
+            cerr << path << ": " << error << "\n";
+        }
+        if (!parser.getErrors().empty() || !parser.sink.getErrors().empty()) {
+            return false;
+        }
+    }
+
+    if (outputPath.empty()) {
+        OutputBuffer(1).write(code);
+    }
+    else {
+        ofstream(outputPath, ios::binary) << code;
+    }
+    return true;
+}
+
 int main(int argc, char *argv[]) {
 
+    // --xml prints nand2tetris XML instead of the tree diagram,
+    // --binary prints the tree in the format read by MappedTree,
+    // --cache DIR keeps parse trees of a whole program between runs,
+    // --memory prints what a file's parse costs in memory instead of its tree,
+    // --parallel parses the subroutines of a single file on every core,
+    // --shared stores identical subtrees of a single file once (try it with --memory),
+    // --explicit-stack parses a single file without recursion, so deep nesting cannot overflow the stack
+    //   (a program's files are always parsed that way, on worker threads with small stacks),
+    // --vm compiles to Hack VM code: one file to standard output, or each file of a program to a .vm beside it,
+    // --profile PREFIX writes PREFIX.json and PREFIX.trace.json (needs PARSER_PROFILE)
+    bool xml = false;
+    bool binary = false;
+    bool memory = false;
+    bool vm = false;
+    bool parallel = false;
+    bool shared = false;
+    ParseMode mode = ParseMode::Recursive;
+    string cacheDirectory;
+    string profilePrefix;
+    int first = 1;
+    while (first < argc && string(argv[first]).rfind("--", 0) == 0) {
+        string flag = argv[first++];
+        if (flag == "--xml") {
+            xml = true;
+        }
+        else if (flag == "--binary") {
+            binary = true;
+        }
+        else if (flag == "--memory") {
+            memory = true;
+        }
+        else if (flag == "--vm") {
+            vm = true;
+        }
+        else if (flag == "--parallel") {
+            parallel = true;
+        }
+        else if (flag == "--shared") {
+            shared = true;
+        }
+        else if (flag == "--explicit-stack") {
+            mode = ParseMode::ExplicitStack;
+        }
+        else if (flag == "--cache" && first < argc) {
+            cacheDirectory = argv[first++];
+        }
+        else if (flag == "--profile" && first < argc) {
+            profilePrefix = argv[first++];
+#ifndef PARSER_PROFILE
+            cout << "--profile needs a build with -DPARSER_PROFILE" << endl;
+            return 1;
+#endif
+        }
+        else {
+            cout << "Unknown option " << flag << endl;
+            return 1;
+        }
+    }
+    int paths = argc - first;
+
+    if (vm && paths > 0) {
+        try {
+            if (paths == 1 && !filesystem::is_directory(argv[first])) {
+                return compileVm(argv[first], "", mode) ? 0 : 1;
+            }
+            Driver driver;
+            for (int i = first; i < argc; i++) {
+                driver.addPath(argv[i]);
+            }
+            bool ok = true;
+            for (const string& path : driver.getPaths()) {
+                ok = compileVm(path, filesystem::path(path).replace_extension(".vm").string(), ParseMode::ExplicitStack) && ok;
+            }
+            return ok ? 0 : 1;
+        } catch (ParseException& e) {
+            cout << "Error Parsing!" << endl;
+            return 1;
+        } catch (runtime_error& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+    }
+
+    // compile a whole program: a directory, or several files
+    if (paths > 1 || (paths == 1 && filesystem::is_directory(argv[first]))) {
+        Driver driver;
+        unique_ptr<ParseCache> cache;
+        if (!cacheDirectory.empty()) {
+            cache = make_unique<ParseCache>(cacheDirectory);
+            driver.setCache(cache.get());
+        }
+        for (int i = first; i < argc; i++) {
+            driver.addPath(argv[i]);
+        }
+        vector<FileResult> results = driver.run();
+        driver.report(results, cout);
+        writeProfile(profilePrefix);
+
+        for (const FileResult& result : results) {
+            if (!result.ok) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    // parse a single .jack file given on the command line, reporting every error in it
+    if (paths == 1) {
+        try {
+            MappedFile file(argv[first]);
+            TokenBuffer tokens = Tokenizer(file.text()).tokenize();
+            ParseResult result;
+            vector<ParseError> errors;
+            if (shared) {
+                BasicParser<HashConsSink> parser(tokens);
+                parser.setRecovery(true);
+                parser.setMode(mode);
+                result = parser.sink.release(parser.compileClass());
+                if (parser.current()->getKind() != NodeKind::Eof) {
+                    parser.fail(NodeKind::Eof);
+                }
+                errors = parser.getErrors();
+            }
+            else {
+                CompilerParser parser(tokens);
+                parser.setRecovery(true);
+                parser.setMode(mode);
+                ParseTree* root;
+                if (parallel) {
+                    ThreadPool pool;
+                    root = parser.compileClassParallel(pool);
+                }
+                else {
+                    root = parser.compileClass();
+                }
+                result = parser.release(root);
+                if (parser.current()->getKind() != NodeKind::Eof) {
+                    parser.fail(NodeKind::Eof);
+                }
+                errors = parser.getErrors();
+            }
+
+            if (!errors.empty()) {
+                LineIndex lines(file.text());
+                for (const ParseError& error : errors) {
+                    cerr << argv[first] << ":" << error.describe(lines) << "\n";
+                }
+                return 1;
+            }
+
+            if (memory) {
+                MemoryReport::of(result, &tokens).writeJson(cout);
+                return 0;
+            }
+
+            OutputBuffer out(1);
+            if (xml) {
+                TreeWriter::writeXml(result.getRoot(), out);
+            }
+            else if (binary) {
+                TreeWriter::writeBinary(FlatTree(result.getRoot()), out);
+            }
+            else {
+                TreeWriter::writeText(result.getRoot(), out);
+                out.put('\n');
+            }
+            writeProfile(profilePrefix);
+        } catch (ParseException& e) {
+            // the tokenizer still stops at the first character it cannot read
+            cout << "Error Parsing!" << endl;
+            return 1;
+        } catch (runtime_error& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
     /* Tokens for:
         class Main { function void test ( ) { } }  
      */
-    list<Token*> tokens;
-        tokens.push_back(new Token("symbol", "{"));
-        tokens.push_back(new Token("keyword", "var"));
-        tokens.push_back(new Token("keyword", "int"));
-        tokens.push_back(new Token("identifier", "a"));  
-        tokens.push_back(new Token("symbol", ";"));
-        tokens.push_back(new Token("symbol", "}"));
+    TokenBuffer tokens;
+        tokens.add(NodeKind::Symbol, Atoms::LeftBrace);
+        tokens.add(NodeKind::Keyword, Atoms::Var);
+        tokens.add(NodeKind::Keyword, Atoms::Int);
+        tokens.add(NodeKind::Identifier, Interner::global().intern("a"));
+        tokens.add(NodeKind::Symbol, Atoms::Semicolon);
+        tokens.add(NodeKind::Symbol, Atoms::RightBrace);
     try {
         CompilerParser parser(tokens);
-        ParseTree* result = parser.compileSubroutineBody();
-        if (result != NULL){
-            cout << result->tostring() << endl;
+        ParseResult result = parser.release(parser.compileSubroutineBody());
+        if (result.getRoot() != NULL){
+            cout << result.getRoot()->tostring() << endl;
         }
-    } catch (ParseException e) {
+    } catch (ParseException& e) {
         cout << "Error Parsing!" << endl;
     }
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * Map a file into memory
+ * @param path The file to map
+ * @throws std::runtime_error if the file cannot be opened or read
+ */
+MappedFile::MappedFile(const string& path) {
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("cannot open " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw runtime_error("cannot stat " + path);
+    }
+    length = (size_t) info.st_size;
+
+    // an empty file cannot be mapped, and does not need to be
+    if (length > 0) {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("cannot map " + path);
+        }
+        madvise(address, length, MADV_SEQUENTIAL);
+        bytes = (const char*) address;
+        mapped = true;
+    }
+    close(fd);
+#else
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        throw runtime_error("cannot open " + path);
+    }
+    fseek(file, 0, SEEK_END);
+    length = (size_t) ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* buffer = new char[length + 1];
+    if (fread(buffer, 1, length, file) != length) {
+        delete[] buffer;
+        fclose(file);
+        throw runtime_error("cannot read " + path);
+    }
+    fclose(file);
+    bytes = buffer;
+#endif
+}
+
+/**
+ * Unmap the file
+ */
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (mapped) {
+        munmap((void*) bytes, length);
+    }
+#else
+    delete[] bytes;
+#endif
+}
@@ -0,0 +1,31 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * The contents of a file, mapped into memory read-only.
+ * On systems without mmap the file is read into a heap buffer instead.
+ */
+class MappedFile {
+    private:
+        const char* bytes;
+        size_t length;
+        bool mapped;
+
+    public:
+        MappedFile(const std::string& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const { return bytes; }
+        size_t size() const { return length; }
+
+        std::string_view text() const { return std::string_view(bytes, length); }
+};
+
+#endif /*MAPPEDFILE_H*/
@@ -0,0 +1,85 @@
+#include "MappedTree.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * Map a binary parse tree file
+ * @param path The file written by TreeWriter::writeBinary()
+ * @throws std::runtime_error if the file cannot be read or is not a valid tree
+ */
+MappedTree::MappedTree(const string& path) {
+    file = make_unique<MappedFile>(path);
+    load(file->data(), file->size());
+}
+
+/**
+ * Read a binary parse tree from memory. The bytes are borrowed and must
+ * outlive the MappedTree, and must be at least 4-byte aligned.
+ * @param bytes The tree, as written by TreeWriter::writeBinary()
+ * @param size The number of bytes
+ * @throws std::runtime_error if the bytes are not a valid tree
+ */
+MappedTree::MappedTree(const char* bytes, size_t size) {
+    load(bytes, size);
+}
+
+/**
+ * Check the header and section sizes, and find each section
+ */
+void MappedTree::load(const char* bytes, size_t size) {
+    using namespace BinaryFormat;
+
+    if (size < sizeof(Header)) {
+        throw runtime_error("parse tree file is truncated");
+    }
+    header = (const Header*) bytes;
+    if (header->magic != MAGIC) {
+        throw runtime_error("not a parse tree file");
+    }
+    if (header->version != VERSION) {
+        throw runtime_error("unsupported parse tree file version");
+    }
+
+    uint64_t needed = sizeof(Header)
+                      + (uint64_t) header->nodeCount * sizeof(Node)
+                      + (uint64_t) header->kindCount * sizeof(uint32_t)
+                      + (uint64_t) header->stringCount * sizeof(String)
+                      + header->dataSize;
+    if (needed > size || header->nodeCount == 0) {
+        throw runtime_error("parse tree file is truncated");
+    }
+    if (header->kindCount > MAX_KINDS) {
+        throw runtime_error("parse tree file has a bad kind table");
+    }
+
+    nodes = (const Node*) (bytes + sizeof(Header));
+    kindNames = (const uint32_t*) (nodes + header->nodeCount);
+    strings = (const String*) (kindNames + header->kindCount);
+    data = (const char*) (strings + header->stringCount);
+
+    for (uint32_t i = 0; i < header->stringCount; i++) {
+        if ((uint64_t) strings[i].offset + strings[i].length > header->dataSize) {
+            throw runtime_error("parse tree file has a bad string table");
+        }
+    }
+    for (uint32_t i = 0; i < header->kindCount; i++) {
+        if (kindNames[i] >= header->stringCount) {
+            throw runtime_error("parse tree file has a bad kind table");
+        }
+        const String& name = strings[kindNames[i]];
+        kinds.push_back(kindFromName(string_view(data + name.offset, name.length)));
+    }
+    for (uint32_t i = 0; i < header->nodeCount; i++) {
+        const Node& node = nodes[i];
+        if (node.kind >= header->kindCount || node.value >= header->stringCount
+            || (uint64_t) node.firstChild + node.childCount > header->nodeCount) {
+            throw runtime_error("parse tree file has a bad node");
+        }
+        // in breadth-first order children come after their parent, so following them always ends
+        if (node.childCount != 0 && node.firstChild <= i) {
+            throw runtime_error("parse tree file has a bad node");
+        }
+    }
+}
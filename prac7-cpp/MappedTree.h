@@ -0,0 +1,91 @@
+#ifndef MAPPEDTREE_H
+#define MAPPEDTREE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+#include "NodeKind.h"
+
+/**
+ * Layout of the binary parse tree format written by TreeWriter::writeBinary().
+ * All fields are in the writer's byte order; a reader with the other byte
+ * order sees a wrong magic number and rejects the file.
+ *
+ *   header
+ *   nodes[nodeCount]       breadth-first, so each node's children are contiguous
+ *   kinds[kindCount]       string index of each kind's name
+ *   strings[stringCount]   offset and length of each string in the data
+ *   data[dataSize]         string bytes, each followed by a NUL
+ */
+namespace BinaryFormat {
+    const uint32_t MAGIC = 0x54504B4A; // "JKPT"
+    const uint32_t VERSION = 1;
+
+    // far more kinds than the parser has; each one becomes a NodeKind in the reading process
+    const uint32_t MAX_KINDS = 256;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t nodeCount;
+        uint32_t kindCount;
+        uint32_t stringCount;
+        uint32_t dataSize;
+        uint32_t reserved[2];
+    };
+
+    struct Node {
+        uint16_t kind;       // index into the kind table
+        uint16_t reserved;
+        uint32_t value;      // index into the string table
+        uint32_t firstChild;
+        uint32_t childCount;
+    };
+
+    struct String {
+        uint32_t offset;
+        uint32_t length;
+    };
+}
+
+/**
+ * A parse tree in the binary format, read in place from a mapped file or a
+ * buffer without building any nodes. Node 0 is the root.
+ */
+class MappedTree {
+    private:
+        std::unique_ptr<MappedFile> file;
+
+        const BinaryFormat::Header* header;
+        const BinaryFormat::Node* nodes;
+        const uint32_t* kindNames;
+        const BinaryFormat::String* strings;
+        const char* data;
+
+        // the kind table translated to this process's NodeKind values
+        std::vector<NodeKind> kinds;
+
+        void load(const char* bytes, size_t size);
+
+    public:
+        MappedTree(const std::string& path);
+        MappedTree(const char* bytes, size_t size);
+
+        uint32_t size() const { return header->nodeCount; }
+
+        NodeKind kind(uint32_t node) const { return kinds[nodes[node].kind]; }
+
+        std::string_view value(uint32_t node) const {
+            const BinaryFormat::String& entry = strings[nodes[node].value];
+            return std::string_view(data + entry.offset, entry.length);
+        }
+
+        uint32_t firstChild(uint32_t node) const { return nodes[node].firstChild; }
+        uint32_t childCount(uint32_t node) const { return nodes[node].childCount; }
+};
+
+#endif /*MAPPEDTREE_H*/
@@ -0,0 +1,81 @@
+#include "MemoryReport.h"
+
+#include <unordered_set>
+
+using namespace std;
+
+/**
+ * Measure a parse tree
+ * @param result The tree and the Arena it was built in
+ * @param tokens The parser's input, or nullptr to leave it out
+ * @return The report
+ */
+MemoryReport MemoryReport::of(const ParseResult& result, const TokenBuffer* tokens) {
+    MemoryReport report;
+    report.nodesByKind.assign((size_t) NodeKind::Count, 0);
+
+    if (result.getArena() != nullptr) {
+        report.allocations = result.getArena()->allocations();
+        report.usedBytes = result.getArena()->bytesUsed();
+        report.peakBytes = result.getArena()->bytesReserved();
+    }
+    if (tokens != nullptr) {
+        report.tokenBytes = tokens->bytesReserved();
+        report.peakBytes += report.tokenBytes;
+    }
+
+    unordered_set<Atom> values;
+    unordered_set<const ParseTree*> seen;
+    vector<const ParseTree*> stack;
+    if (result.getRoot() != nullptr) {
+        stack.push_back(result.getRoot());
+    }
+    while (!stack.empty()) {
+        const ParseTree* node = stack.back();
+        stack.pop_back();
+
+        size_t kind = (size_t) node->getKind();
+        if (kind >= report.nodesByKind.size()) {
+            report.nodesByKind.resize(kind + 1, 0);
+        }
+        report.nodesByKind[kind]++;
+        report.nodes++;
+        if (seen.insert(node).second) {
+            report.distinctNodes++;
+            report.nodeBytes += node->isToken() ? sizeof(Token) : sizeof(ParseTree);
+            report.childBytes += node->childCapacity() * sizeof(ParseTree*);
+        }
+
+        if (values.insert(node->getAtom()).second) {
+            report.stringBytes += node->getValue().size();
+        }
+        for (const ParseTree* child : node->getChildren()) {
+            stack.push_back(child);
+        }
+    }
+    return report;
+}
+
+/**
+ * Write the report as one JSON object
+ * @param out Where to write
+ */
+void MemoryReport::writeJson(ostream& out) const {
+    out << "{\"nodes\": " << nodes << ", \"nodesByKind\": {";
+    bool first = true;
+    for (size_t kind = 0; kind < nodesByKind.size(); kind++) {
+        if (nodesByKind[kind] == 0) {
+            continue;
+        }
+        out << (first ? "" : ", ") << "\"" << kindName((NodeKind) kind) << "\": " << nodesByKind[kind];
+        first = false;
+    }
+    out << "}, \"distinctNodes\": " << distinctNodes
+        << ", \"nodeBytes\": " << nodeBytes
+        << ", \"childBytes\": " << childBytes
+        << ", \"stringBytes\": " << stringBytes
+        << ", \"allocations\": " << allocations
+        << ", \"usedBytes\": " << usedBytes
+        << ", \"peakBytes\": " << peakBytes
+        << ", \"tokenBytes\": " << tokenBytes << "}\n";
+}
@@ -0,0 +1,37 @@
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "ParseResult.h"
+#include "TokenBuffer.h"
+
+/**
+ * What one parse costs in memory, for sizing per-compilation limits
+ * (see Arena::setLimit()).
+ *
+ * The Arena counters it reads are kept on every allocation at the cost of
+ * two additions; the tree walk happens only when a report is made.
+ */
+struct MemoryReport {
+    size_t nodes = 0;
+    std::vector<size_t> nodesByKind;   // indexed by NodeKind
+    size_t distinctNodes = 0;          // fewer than nodes when subtrees are shared, see HashConsSink
+
+    size_t nodeBytes = 0;    // ParseTree and Token objects in the tree, input tokens included, once each
+    size_t childBytes = 0;   // child pointer arrays, at their capacity, once each
+    size_t stringBytes = 0;  // text of the distinct values, shared through the Interner, not owned
+
+    size_t allocations = 0;  // taken from the tree's Arena
+    size_t usedBytes = 0;    // handed out by the Arena, including child arrays since outgrown
+    size_t peakBytes = 0;    // reserved by the Arena, which only grows, plus tokenBytes
+    size_t tokenBytes = 0;   // the input TokenBuffer, if one was given
+
+    static MemoryReport of(const ParseResult& result, const TokenBuffer* tokens = nullptr);
+
+    void writeJson(std::ostream& out) const;
+};
+
+#endif /*MEMORYREPORT_H*/
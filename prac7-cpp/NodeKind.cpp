@@ -0,0 +1,48 @@
+#include "NodeKind.h"
+#include "Interner.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * The table of kind names, seeded in the same order as NodeKind
+ * @return The Interner holding kind names
+ */
+static Interner& kindNames() {
+    static Interner names({
+        "keyword", "symbol", "identifier", "integerConstant", "stringConstant",
+        "keywordConstant", "unaryOp",
+        "error",
+        "eof",
+        "class", "classVarDec", "subroutine", "parameterList", "subroutineBody", "varDec",
+        "statements", "letStatement", "ifStatement", "whileStatement", "doStatement", "returnStatement",
+        "expression", "binaryExpression", "term", "expressionList",
+        "lazySubroutineBody"
+    });
+    return names;
+}
+
+/**
+ * Get the kind for a type name (see element types)
+ * @param name The type name, e.g. "identifier" or "whileStatement"
+ * @return The matching NodeKind
+ * @throws runtime_error if a new name would not fit in a NodeKind
+ */
+NodeKind kindFromName(string_view name) {
+    Atom kind = kindNames().intern(name);
+    if (kind > UINT16_MAX) {
+        throw runtime_error("too many node kinds");
+    }
+    return (NodeKind) kind;
+}
+
+/**
+ * Get the type name for a kind
+ * @param kind The NodeKind
+ * @return The type name, e.g. "identifier" or "whileStatement"
+ */
+const string& kindName(NodeKind kind) {
+    return kindNames().str((Atom) kind);
+}
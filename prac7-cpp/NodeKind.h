@@ -0,0 +1,39 @@
+#ifndef NODEKIND_H
+#define NODEKIND_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * The type of a Token or ParseTree node.
+ * Types that are not listed here can still be created from a string
+ * with kindFromName(), and are given values from Count upwards.
+ */
+enum class NodeKind : uint16_t {
+    // terminals
+    Keyword, Symbol, Identifier, IntegerConstant, StringConstant,
+    KeywordConstant, UnaryOp,
+
+    // stands in for a token the parser expected but did not find, in recovery mode
+    Error,
+
+    // marks the end of a TokenBuffer
+    Eof,
+
+    // non-terminals
+    Class, ClassVarDec, Subroutine, ParameterList, SubroutineBody, VarDec,
+    Statements, LetStatement, IfStatement, WhileStatement, DoStatement, ReturnStatement,
+    Expression, BinaryExpression, Term, ExpressionList,
+
+    // a subroutineBody that has not been parsed yet, holding just its braces, see BasicParser::setLazy()
+    LazySubroutineBody,
+
+    Count
+};
+
+NodeKind kindFromName(std::string_view name);
+
+const std::string& kindName(NodeKind kind);
+
+#endif /*NODEKIND_H*/
@@ -0,0 +1,104 @@
+#include "OutputBuffer.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/**
+ * Write bytes to a file descriptor
+ * @return The number of bytes written, or a negative number on error
+ */
+static long writeBytes(int fd, const char* bytes, size_t length) {
+#ifdef _WIN32
+    return _write(fd, bytes, (unsigned) length);
+#else
+    return (long) ::write(fd, bytes, length);
+#endif
+}
+
+/**
+ * A buffer that writes to a file descriptor
+ * @param fd The file descriptor, e.g. 1 for standard output. It is not closed.
+ * @param capacity The size of the buffer in bytes
+ */
+OutputBuffer::OutputBuffer(int fd, size_t capacity) : buffer(capacity) {
+    this->used = 0;
+    this->fd = fd;
+    this->target = nullptr;
+}
+
+/**
+ * A buffer that appends to a string
+ * @param target The string to append to
+ * @param capacity The size of the buffer in bytes
+ */
+OutputBuffer::OutputBuffer(string& target, size_t capacity) : buffer(capacity) {
+    this->used = 0;
+    this->fd = -1;
+    this->target = &target;
+}
+
+/**
+ * Writes out anything still buffered. Errors are ignored here; call flush()
+ * first to have them reported.
+ */
+OutputBuffer::~OutputBuffer() {
+    try {
+        drain();
+    } catch (runtime_error&) {
+    }
+}
+
+/**
+ * Pass the buffered bytes on to the file descriptor or string
+ */
+void OutputBuffer::drain() {
+    if (target != nullptr) {
+        target->append(buffer.data(), used);
+        used = 0;
+        return;
+    }
+
+    size_t done = 0;
+    while (done < used) {
+        long written = writeBytes(fd, buffer.data() + done, used - done);
+        if (written <= 0) {
+            used = 0;
+            throw runtime_error("cannot write output");
+        }
+        done += (size_t) written;
+    }
+    used = 0;
+}
+
+/**
+ * Slow path of write(), for when the bytes do not fit in the space left
+ * @param bytes The bytes to write
+ * @param length The number of bytes
+ */
+void OutputBuffer::writeSlow(const char* bytes, size_t length) {
+    while (length > 0) {
+        if (used == buffer.size()) {
+            drain();
+        }
+        size_t chunk = min(length, buffer.size() - used);
+        memcpy(buffer.data() + used, bytes, chunk);
+        used += chunk;
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+/**
+ * Pass on everything written so far
+ */
+void OutputBuffer::flush() {
+    drain();
+}
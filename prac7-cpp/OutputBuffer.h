@@ -0,0 +1,55 @@
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * A fixed-size write buffer in front of a file descriptor or a string.
+ * Output is passed on whenever the buffer fills up, and on flush() and
+ * destruction, so memory use does not grow with the amount written.
+ */
+class OutputBuffer {
+    private:
+        std::vector<char> buffer;
+        size_t used;
+        int fd;
+        std::string* target;
+
+        void drain();
+
+    public:
+        OutputBuffer(int fd, size_t capacity = 1 << 16);
+        OutputBuffer(std::string& target, size_t capacity = 1 << 16);
+        ~OutputBuffer();
+
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+        void write(const char* bytes, size_t length) {
+            if (length > buffer.size() - used) {
+                writeSlow(bytes, length);
+                return;
+            }
+            memcpy(buffer.data() + used, bytes, length);
+            used += length;
+        }
+
+        void write(std::string_view text) { write(text.data(), text.size()); }
+
+        void put(char c) {
+            if (used == buffer.size()) {
+                drain();
+            }
+            buffer[used++] = c;
+        }
+
+        void writeSlow(const char* bytes, size_t length);
+
+        void flush();
+};
+
+#endif /*OUTPUTBUFFER_H*/
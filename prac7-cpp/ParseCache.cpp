@@ -0,0 +1,192 @@
+#include "ParseCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "OutputBuffer.h"
+#include "TreeWriter.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const char* const EXTENSION = ".jkt";
+
+/**
+ * Hash bytes 8 at a time, starting from a seed
+ * @return A 64-bit hash of text
+ */
+static uint64_t hash64(string_view text, uint64_t seed) {
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t h = (seed ^ text.size()) * multiplier;
+    const char* bytes = text.data();
+    size_t left = text.size();
+
+    while (left >= 8) {
+        uint64_t chunk;
+        memcpy(&chunk, bytes, 8);
+        h = (h ^ chunk) * multiplier;
+        h ^= h >> 29;
+        bytes += 8;
+        left -= 8;
+    }
+    if (left > 0) {
+        uint64_t chunk = 0;
+        memcpy(&chunk, bytes, left);
+        h = (h ^ chunk) * multiplier;
+        h ^= h >> 29;
+    }
+    h ^= h >> 32;
+    h *= multiplier;
+    return h ^ (h >> 29);
+}
+
+/**
+ * Constructor for a ParseCache. The directory is created if needed.
+ * @param directory Where the cached trees are kept
+ * @param maxBytes How large the directory may grow before evict() deletes entries
+ */
+ParseCache::ParseCache(const string& directory, uint64_t maxBytes) {
+    this->directory = directory;
+    this->maxBytes = maxBytes;
+    fs::create_directories(directory);
+}
+
+/**
+ * Get the key of a source file: two independent 64-bit hashes of its text,
+ * the parser version and the binary format version
+ * @param source The text of a .jack file
+ * @return The key, usable as a file name
+ */
+string ParseCache::key(string_view source) {
+    char text[64];
+    snprintf(text, sizeof(text), "%016llx%016llx-%u-%u",
+             (unsigned long long) hash64(source, 0),
+             (unsigned long long) hash64(source, 0x5851F42D4C957F2Dull),
+             (unsigned) PARSER_VERSION, (unsigned) BinaryFormat::VERSION);
+    return text;
+}
+
+string ParseCache::pathFor(const string& key) const {
+    return (fs::path(directory) / (key + EXTENSION)).string();
+}
+
+/**
+ * Look up a cached tree. A hit marks the entry as recently used.
+ * @param key The key of the source file
+ * @return The tree, mapped from the cache, or nullptr if there is no valid entry
+ */
+unique_ptr<MappedTree> ParseCache::load(const string& key) {
+    string path = pathFor(key);
+    error_code error;
+    if (!fs::exists(path, error)) {
+        return nullptr;
+    }
+
+    unique_ptr<MappedTree> tree;
+    try {
+        tree = make_unique<MappedTree>(path);
+    } catch (runtime_error&) {
+        // damaged, or deleted by another build since it was found
+        fs::remove(path, error);
+        return nullptr;
+    }
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    return tree;
+}
+
+/**
+ * Add a tree to the cache. Failures, such as a full disk, are not errors:
+ * the tree is simply not cached.
+ * @param key The key of the source file
+ * @param tree The parse tree of that file
+ * @return true if the entry was written
+ */
+bool ParseCache::store(const string& key, const FlatTree& tree) {
+    static atomic<uint64_t> counter(0);
+    static const uint64_t salt = random_device()() * 0x100000001ull ^ random_device()();
+
+    string bytes;
+    {
+        OutputBuffer out(bytes);
+        TreeWriter::writeBinary(tree, out);
+    }
+
+    // unique across threads and, by the random salt, across processes
+    char suffix[40];
+    snprintf(suffix, sizeof(suffix), ".%016llx.%llu.tmp", (unsigned long long) salt,
+             (unsigned long long) counter.fetch_add(1));
+    string temporary = pathFor(key) + suffix;
+
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        file.write(bytes.data(), (streamsize) bytes.size());
+        if (!file.good()) {
+            error_code error;
+            fs::remove(temporary, error);
+            return false;
+        }
+    }
+
+    // another build storing the same key at once writes identical bytes, so either rename may win
+    error_code error;
+    fs::rename(temporary, pathFor(key), error);
+    if (error) {
+        fs::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Delete the least recently used entries until the cache is within its
+ * size limit. Also removes temporary files left behind by crashed builds.
+ */
+void ParseCache::evict() {
+    struct Entry {
+        fs::path path;
+        fs::file_time_type used;
+        uint64_t size;
+    };
+
+    vector<Entry> entries;
+    uint64_t total = 0;
+    error_code error;
+    auto stale = fs::file_time_type::clock::now() - chrono::hours(1);
+
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory, error)) {
+        error_code entryError;
+        fs::file_time_type used = entry.last_write_time(entryError);
+        uint64_t size = entry.file_size(entryError);
+        if (entryError) {
+            continue; // removed by another build
+        }
+
+        if (entry.path().extension() == ".tmp") {
+            if (used < stale) {
+                fs::remove(entry.path(), entryError);
+            }
+        }
+        else if (entry.path().extension() == EXTENSION) {
+            entries.push_back({entry.path(), used, size});
+            total += size;
+        }
+    }
+
+    sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.used < b.used;
+    });
+    for (const Entry& entry : entries) {
+        if (total <= maxBytes) {
+            break;
+        }
+        fs::remove(entry.path, error);
+        total -= entry.size;
+    }
+}
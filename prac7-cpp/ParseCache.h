@@ -0,0 +1,48 @@
+#ifndef PARSECACHE_H
+#define PARSECACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "FlatTree.h"
+#include "MappedTree.h"
+
+/**
+ * Changes whenever the trees built by compileClass() change shape, so that
+ * cached trees from an older parser are never used.
+ */
+const uint32_t PARSER_VERSION = 1;
+
+/**
+ * A directory of parse trees in the binary format, keyed by a hash of the
+ * source text and the parser version, so an unchanged file can skip
+ * tokenizing and parsing entirely.
+ *
+ * Several builds may share one directory at once. Entries are written to a
+ * temporary file and renamed into place, so a reader only ever sees whole
+ * entries, and every entry is validated when it is loaded. Once the
+ * directory grows past its size limit, the least recently used entries
+ * are deleted by evict().
+ */
+class ParseCache {
+    private:
+        std::string directory;
+        uint64_t maxBytes;
+
+        std::string pathFor(const std::string& key) const;
+
+    public:
+        ParseCache(const std::string& directory, uint64_t maxBytes = 256u << 20);
+
+        static std::string key(std::string_view source);
+
+        std::unique_ptr<MappedTree> load(const std::string& key);
+
+        bool store(const std::string& key, const FlatTree& tree);
+
+        void evict();
+};
+
+#endif /*PARSECACHE_H*/
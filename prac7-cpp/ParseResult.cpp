@@ -0,0 +1,36 @@
+#include "ParseResult.h"
+
+using namespace std;
+
+/**
+ * An empty ParseResult with no tree
+ */
+ParseResult::ParseResult() {
+    root = nullptr;
+}
+
+/**
+ * Constructor for a ParseResult
+ * @param arena The Arena holding the tree's nodes
+ * @param root The root of the tree
+ */
+ParseResult::ParseResult(unique_ptr<Arena> arena, ParseTree* root) {
+    ParseResult::arena = move(arena);
+    ParseResult::root = root;
+}
+
+/**
+ * Get the root of the tree
+ * @return The root node, or nullptr for an empty result
+ */
+ParseTree* ParseResult::getRoot() const {
+    return root;
+}
+
+/**
+ * Get the Arena the tree lives in
+ * @return The Arena, or nullptr for an empty result
+ */
+Arena* ParseResult::getArena() const {
+    return arena.get();
+}
@@ -0,0 +1,31 @@
+#ifndef PARSERESULT_H
+#define PARSERESULT_H
+
+#include <memory>
+
+#include "Arena.h"
+#include "ParseTree.h"
+
+/**
+ * A finished parse tree together with the Arena its nodes live in.
+ *
+ * Ownership: every non-terminal node, and every token the parser had to
+ * synthesize, was allocated from the Arena and is freed in one step when
+ * the ParseResult is destroyed. Leaves that are tokens from the parser's
+ * input are borrowed, not owned; the input tokens must outlive the result.
+ */
+class ParseResult {
+    private:
+        std::unique_ptr<Arena> arena;
+        ParseTree* root;
+
+    public:
+        ParseResult();
+        ParseResult(std::unique_ptr<Arena> arena, ParseTree* root);
+
+        ParseTree* getRoot() const;
+
+        Arena* getArena() const;
+};
+
+#endif /*PARSERESULT_H*/
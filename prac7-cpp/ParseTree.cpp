@@ -1,4 +1,6 @@
 #include "ParseTree.h"
+#include "Token.h"
+#include "TreeWriter.h"
 
 using namespace std;
 
@@ -8,12 +10,26 @@ using namespace std;
  * @param value The node's value. This should only be present on terminal nodes/leaves, and empty otherwise.
  */
 ParseTree::ParseTree(string type, string value) {
-    ParseTree::type = type;
+    ParseTree::kind = kindFromName(type);
+    ParseTree::token = false;
+    ParseTree::value = Interner::global().intern(value);
+}
+
+/**
+ * A node in a Parse Tree data structure
+ * @param kind The type of node (see element types).
+ * @param value The interned value of the node, Atoms::Empty for non-terminals.
+ * @param memory Where the list of children is allocated. Nodes placed in an Arena pass the Arena here.
+ */
+ParseTree::ParseTree(NodeKind kind, Atom value, pmr::memory_resource* memory) : children(memory) {
+    ParseTree::kind = kind;
+    ParseTree::token = false;
     ParseTree::value = value;
 }
 
 /**
- * Adds a ParseTree as a child of this ParseTree
+ * Adds a ParseTree as a child of this ParseTree.
+ * Children are kept in one contiguous array, read them back with getChildren().
  * @param child The ParseTree to add
  */
 void ParseTree::addChild(ParseTree* child) {
@@ -21,27 +37,91 @@ void ParseTree::addChild(ParseTree* child) {
 }
 
 /**
- * Get a list of child nodes in the order they were added.
- * @return A LinkedList of ParseTrees
+ * Replaces one child of this ParseTree. The old child is not freed.
+ * @param index The position of the child to replace
+ * @param child The ParseTree to put in its place
+ */
+void ParseTree::replaceChild(size_t index, ParseTree* child) {
+    ParseTree::children[index] = child;
+}
+
+/**
+ * Remove the children from a position onwards
+ * @param from The position of the first child to remove
+ */
+void ParseTree::removeChildren(size_t from) {
+    ParseTree::children.resize(from);
+}
+
+/**
+ * Find the first (or last) token from the input in this subtree.
+ * Uses a stack rather than recursion, so deep trees do not use native stack.
+ * @param first true for the first token, false for the last
+ * @return The token, nullptr if no token in the subtree came from the input
+ */
+const Token* ParseTree::edgeToken(bool first) const {
+    vector<const ParseTree*> stack;
+    stack.push_back(this);
+    while (!stack.empty()) {
+        const ParseTree* node = stack.back();
+        stack.pop_back();
+        if (node->isToken()) {
+            const Token* found = static_cast<const Token*>(node);
+            if (found->getSpan().known()) {
+                return found;
+            }
+            continue;
+        }
+
+        // push the children so the one nearest the edge is visited next
+        ChildRange children = node->getChildren();
+        if (first) {
+            for (size_t i = children.size(); i > 0; i--) {
+                stack.push_back(children[i - 1]);
+            }
+        }
+        else {
+            for (ParseTree* child : children) {
+                stack.push_back(child);
+            }
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Find where this node is in the source. Only tokens store a span; a node's
+ * runs from the start of its first token from the input to the end of its
+ * last, found by following its edge children down, so it costs nothing
+ * until it is asked for.
+ * @return The span, unknown if no token in the node came from the input
  */
-list<ParseTree*> ParseTree::getChildren() {
-    return ParseTree::children;
+Span ParseTree::span() const {
+    if (token) {
+        return static_cast<const Token*>(this)->getSpan();
+    }
+    const Token* first = edgeToken(true);
+    if (first == nullptr) {
+        return Span();
+    }
+    Span last = edgeToken(false)->getSpan();
+    return Span{first->getSpan().offset, last.end() - first->getSpan().offset};
 }
 
 /**
  * Get the type of this Node
  * @return The type of node (see element types).
  */
-string ParseTree::getType() {
-    return ParseTree::type;
+const string& ParseTree::getType() const {
+    return kindName(ParseTree::kind);
 }
 
 /**
  * Get the value of this Node
  * @return The node's value. This should only be used on terminal nodes/leaves, and empty otherwise.
  */
-string ParseTree::getValue() {
-    return ParseTree::value;
+const string& ParseTree::getValue() const {
+    return Interner::global().str(ParseTree::value);
 }
 
 /**
@@ -57,24 +137,10 @@ string ParseTree::tostring() {
  * @return A printable representation of this ParseTree with indentation
  */
 string ParseTree::tostring(int depth) {
-    // Set indentation
-    string indent = "";
-    for (int i = 0; i < depth; i++) {
-        indent += "  \u2502 ";
-    }
-
-    // Generate output
-    string output = "";
-    if (ParseTree::children.size() > 0) {
-        // Output if the node has children
-        output += ParseTree::type + "\n";
-        for (ParseTree* child : children) {
-            output += indent + "  \u2514 " + child->tostring(depth + 1);
-        }
-        output += indent + "\n";
-    } else {
-        // Output if the node is a leaf/terminal
-        output += ParseTree::type + " " + ParseTree::value + "\n";
+    string output;
+    {
+        OutputBuffer out(output);
+        TreeWriter::writeText(this, out, depth);
     }
     return output;
-}
\ No newline at end of file
+}
@@ -1,29 +1,115 @@
 #ifndef PARSETREE_H
 #define PARSETREE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <list>
+#include <vector>
+#include <memory_resource>
+
+#include "Interner.h"
+#include "NodeKind.h"
+
+class ParseTree;
+class Token;
+
+/**
+ * Where a token or node is in the source text, as a byte offset and length
+ */
+struct Span {
+    static const uint32_t UNKNOWN = UINT32_MAX;
+
+    uint32_t offset = UNKNOWN;
+    uint32_t length = 0;
+
+    // false for tokens the parser made and nodes without any token from the input
+    bool known() const { return offset != UNKNOWN; }
+
+    uint32_t end() const { return offset + length; }
+};
+
+/**
+ * A view of a node's children. Iterating it does not copy anything.
+ * The view is invalidated by adding more children to the node.
+ */
+class ChildRange {
+    private:
+        ParseTree* const* first;
+        ParseTree* const* last;
+
+    public:
+        ChildRange(ParseTree* const* first, ParseTree* const* last) : first(first), last(last) {}
+
+        ParseTree* const* begin() const { return first; }
+        ParseTree* const* end() const { return last; }
+
+        size_t size() const { return (size_t) (last - first); }
+        bool empty() const { return first == last; }
+
+        ParseTree* operator[](size_t index) const { return first[index]; }
+        ParseTree* front() const { return *first; }
+        ParseTree* back() const { return *(last - 1); }
+};
 
 class ParseTree {
     private:
-        std::string type;
-        std::string value;
-        std::list<ParseTree*> children;
+        NodeKind kind;
+        bool token;     // this is a Token, see span(); fits in the padding after kind
+        Atom value;
+        std::pmr::vector<ParseTree*> children;
+
+        friend class Token;
 
     public:
         ParseTree(std::string type, std::string value);
 
+        ParseTree(NodeKind kind, Atom value = Atoms::Empty,
+                  std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
         void addChild(ParseTree* child);
 
-        std::list<ParseTree*> getChildren();
+        void replaceChild(size_t index, ParseTree* child);
+
+        void removeChildren(size_t from);
+
+        // make room for this many children, so a node whose children are known up front is allocated once
+        void reserveChildren(size_t count) { children.reserve(count); }
+
+        ChildRange getChildren() const {
+            return ChildRange(children.data(), children.data() + children.size());
+        }
+
+        // room in the child array, for memory accounting
+        size_t childCapacity() const { return children.capacity(); }
+
+        NodeKind getKind() const { return kind; }
+
+        Atom getAtom() const { return value; }
+
+        // true for Tokens, whose span is known, false for nodes whose span is derived
+        bool isToken() const { return token; }
+
+        Span span() const;
+
+        // the first (or last) token from the input in this subtree, nullptr if there is none
+        const Token* edgeToken(bool first) const;
+
+        bool is(NodeKind expectedKind, Atom expectedValue) const {
+            return kind == expectedKind && value == expectedValue;
+        }
+
+        // the keyword's id, an Atoms value below KeywordCount, or KeywordCount if this is not a keyword
+        Atom keyword() const {
+            return kind == NodeKind::Keyword && value < Atoms::KeywordCount ? value : (Atom) Atoms::KeywordCount;
+        }
 
-        std::string getType();
+        const std::string& getType() const;
 
-        std::string getValue();
+        const std::string& getValue() const;
 
         std::string tostring();
 
         std::string tostring(int depth);
 };
 
-#endif /*PARSETREE_H*/
\ No newline at end of file
+#endif /*PARSETREE_H*/
@@ -0,0 +1,184 @@
+#include "Profiler.h"
+
+#include <chrono>
+
+using namespace std;
+
+// events kept per thread for the trace, so a huge parse cannot exhaust memory
+const size_t MAX_EVENTS = 1 << 20;
+
+static const char* const NAMES[] = {
+    "compileProgram", "compileClass", "compileClassVarDec", "compileSubroutine",
+    "compileParameterList", "compileSubroutineBody", "compileVarDec",
+    "compileStatements", "compileLet", "compileIf", "compileWhile", "compileDo", "compileReturn",
+    "compileExpression", "compileBinary", "compileTerm", "compileExpressionList",
+    "iterateStatements", "iterateExpression",
+    "have", "mustBe", "next"
+};
+
+mutex Profiler::registryLock;
+vector<unique_ptr<Profiler>> Profiler::registry;
+
+/**
+ * Constructor for a Profiler
+ * @param thread A number identifying the thread in the trace
+ */
+Profiler::Profiler(uint32_t thread) {
+    this->thread = thread;
+    for (int i = 0; i < (int) ProfilePoint::Count; i++) {
+        active[i] = 0;
+    }
+}
+
+/**
+ * Get the calling thread's Profiler, creating it on first use.
+ * Profilers live until the program ends, so their numbers outlive their threads.
+ * @return The Profiler
+ */
+Profiler& Profiler::forThread() {
+    thread_local Profiler* profiler = nullptr;
+    if (profiler == nullptr) {
+        lock_guard<mutex> guard(registryLock);
+        registry.push_back(unique_ptr<Profiler>(new Profiler((uint32_t) registry.size() + 1)));
+        profiler = registry.back().get();
+    }
+    return *profiler;
+}
+
+/**
+ * @return Nanoseconds on a monotonic clock
+ */
+uint64_t Profiler::now() {
+    return (uint64_t) chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Start a call
+ * @param point The function called
+ * @param cursor The parser's current token
+ */
+void Profiler::enter(ProfilePoint point, Token* const* cursor) {
+    int index = (int) point;
+    stats[index].calls++;
+    active[index]++;
+    if (active[index] > stats[index].maxDepth) {
+        stats[index].maxDepth = active[index];
+    }
+    frames.push_back({point, now(), 0, cursor});
+}
+
+/**
+ * Finish the innermost call
+ * @param cursor The parser's current token
+ */
+void Profiler::leave(Token* const* cursor) {
+    Frame frame = frames.back();
+    frames.pop_back();
+    int index = (int) frame.point;
+    uint64_t duration = now() - frame.startNs;
+
+    stats[index].exclusiveNs += duration - frame.childNs;
+    if (!frames.empty()) {
+        frames.back().childNs += duration;
+    }
+
+    // a recursive call's time and tokens are already part of the outermost call's
+    if (--active[index] == 0) {
+        stats[index].inclusiveNs += duration;
+        stats[index].tokens += (uint64_t) (cursor - frame.startCursor);
+    }
+
+    if (frame.point < ProfilePoint::Have && events.size() < MAX_EVENTS) {
+        events.push_back({frame.point, frame.startNs, duration});
+    }
+}
+
+/**
+ * Forget everything recorded so far, on every thread. No thread may be
+ * parsing at the time.
+ */
+void Profiler::reset() {
+    lock_guard<mutex> guard(registryLock);
+    for (unique_ptr<Profiler>& profiler : registry) {
+        for (int i = 0; i < (int) ProfilePoint::Count; i++) {
+            profiler->stats[i] = Stats();
+        }
+        profiler->events.clear();
+    }
+}
+
+/**
+ * Write the totals of every thread as JSON: one object per ProfilePoint
+ * that was called, with calls, tokens, inclusive and exclusive
+ * nanoseconds, and the deepest recursion
+ * @param out Where to write
+ */
+void Profiler::writeJson(ostream& out) {
+    lock_guard<mutex> guard(registryLock);
+
+    Stats totals[(int) ProfilePoint::Count];
+    for (unique_ptr<Profiler>& profiler : registry) {
+        for (int i = 0; i < (int) ProfilePoint::Count; i++) {
+            const Stats& stats = profiler->stats[i];
+            totals[i].calls += stats.calls;
+            totals[i].tokens += stats.tokens;
+            totals[i].inclusiveNs += stats.inclusiveNs;
+            totals[i].exclusiveNs += stats.exclusiveNs;
+            totals[i].maxDepth = max(totals[i].maxDepth, stats.maxDepth);
+        }
+    }
+
+    out << "{\n";
+    bool first = true;
+    for (int i = 0; i < (int) ProfilePoint::Count; i++) {
+        if (totals[i].calls == 0) {
+            continue;
+        }
+        out << (first ? "" : ",\n") << "  \"" << NAMES[i] << "\": {"
+            << "\"calls\": " << totals[i].calls
+            << ", \"tokens\": " << totals[i].tokens
+            << ", \"inclusiveNs\": " << totals[i].inclusiveNs
+            << ", \"exclusiveNs\": " << totals[i].exclusiveNs
+            << ", \"maxDepth\": " << totals[i].maxDepth << "}";
+        first = false;
+    }
+    out << "\n}\n";
+}
+
+/**
+ * Write the calls to compile methods as a Chrome trace-event timeline,
+ * viewable in chrome://tracing or Perfetto. have, mustBe and next are
+ * left out of the timeline, they are too frequent to draw.
+ * @param out Where to write
+ */
+void Profiler::writeTrace(ostream& out) {
+    lock_guard<mutex> guard(registryLock);
+
+    uint64_t origin = UINT64_MAX;
+    for (unique_ptr<Profiler>& profiler : registry) {
+        for (const Event& event : profiler->events) {
+            origin = min(origin, event.startNs);
+        }
+    }
+
+    ios::fmtflags flags = out.flags();
+    out.setf(ios::fixed);
+    streamsize precision = out.precision(3);
+
+    out << "{\"traceEvents\": [\n";
+    bool first = true;
+    for (unique_ptr<Profiler>& profiler : registry) {
+        for (const Event& event : profiler->events) {
+            out << (first ? "" : ",\n") << "{\"name\": \"" << NAMES[(int) event.point]
+                << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << profiler->thread
+                << ", \"ts\": " << (event.startNs - origin) / 1000.0
+                << ", \"dur\": " << event.durationNs / 1000.0 << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,112 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+class Token;
+
+/**
+ * The parser functions that can be profiled
+ */
+enum class ProfilePoint : uint8_t {
+    CompileProgram, CompileClass, CompileClassVarDec, CompileSubroutine,
+    CompileParameterList, CompileSubroutineBody, CompileVarDec,
+    CompileStatements, CompileLet, CompileIf, CompileWhile, CompileDo, CompileReturn,
+    CompileExpression, CompileBinary, CompileTerm, CompileExpressionList,
+    IterateStatements, IterateExpression,
+    Have, MustBe, Next,
+
+    Count
+};
+
+/**
+ * Call counts and timings of the parser, per ProfilePoint.
+ *
+ * Only collected when the parser is compiled with PARSER_PROFILE defined;
+ * otherwise PROFILE_POINT expands to nothing and the parser is unchanged.
+ * Each thread records into its own Profiler, without locking, and the
+ * exports add up every thread's numbers.
+ */
+class Profiler {
+    public:
+        struct Stats {
+            uint64_t calls = 0;
+            uint64_t tokens = 0;       // consumed, counted once per outermost call
+            uint64_t inclusiveNs = 0;  // counted once per outermost call
+            uint64_t exclusiveNs = 0;
+            uint32_t maxDepth = 0;     // deepest recursion into the same point
+        };
+
+    private:
+        // a call in progress
+        struct Frame {
+            ProfilePoint point;
+            uint64_t startNs;
+            uint64_t childNs;
+            Token* const* startCursor;
+        };
+
+        // a finished call to a compile method, for the trace timeline
+        struct Event {
+            ProfilePoint point;
+            uint64_t startNs;
+            uint64_t durationNs;
+        };
+
+        Stats stats[(int) ProfilePoint::Count];
+        uint32_t active[(int) ProfilePoint::Count];
+        std::vector<Frame> frames;
+        std::vector<Event> events;
+        uint32_t thread;
+
+        static std::mutex registryLock;
+        static std::vector<std::unique_ptr<Profiler>> registry;
+
+        Profiler(uint32_t thread);
+
+    public:
+        static Profiler& forThread();
+
+        static uint64_t now();
+
+        void enter(ProfilePoint point, Token* const* cursor);
+        void leave(Token* const* cursor);
+
+        static void reset();
+
+        static void writeJson(std::ostream& out);
+        static void writeTrace(std::ostream& out);
+};
+
+/**
+ * Profiles one call for as long as it is in scope
+ */
+class ProfileScope {
+    private:
+        Profiler& profiler;
+        Token* const* const& cursor;
+
+    public:
+        ProfileScope(ProfilePoint point, Token* const* const& cursor)
+            : profiler(Profiler::forThread()), cursor(cursor) {
+            profiler.enter(point, cursor);
+        }
+
+        ~ProfileScope() { profiler.leave(cursor); }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#ifdef PARSER_PROFILE
+// profile the enclosing CompilerParser member function as the given ProfilePoint
+#define PROFILE_POINT(point) ProfileScope profileScope(ProfilePoint::point, this->cursor)
+#else
+#define PROFILE_POINT(point)
+#endif
+
+#endif /*PROFILER_H*/
@@ -0,0 +1,178 @@
+#include "SymbolTable.h"
+
+using namespace std;
+
+static const size_t FIRST_CAPACITY = 16;
+
+/**
+ * Fibonacci hash of an atom into a table of the given power-of-two size
+ */
+static size_t slotOf(Atom name, size_t capacity) {
+    return (size_t) ((name * 2654435769u) >> 7) & (capacity - 1);
+}
+
+/**
+ * An empty table, ready for the first class
+ */
+SymbolTable::SymbolTable() {
+    this->scopes.resize(1);
+    this->depth = 0;
+    this->nextEpoch = 1; // slots start at epoch 0, which no scope ever uses
+    this->className = Atoms::Empty;
+    clear(scopes[0]);
+}
+
+/**
+ * Empty a scope without touching its slots
+ * @param scope The scope
+ */
+void SymbolTable::clear(Scope& scope) {
+    if (nextEpoch == 0) {
+        renumber();
+    }
+    scope.epoch = nextEpoch++;
+    scope.size = 0;
+    for (uint32_t& count : scope.counts) {
+        count = 0;
+    }
+}
+
+/**
+ * Start the epochs again from 1 once they have run out, so an epoch is
+ * never reused while a slot of an older scope still carries it. Each
+ * scope's current slots are given its new epoch, and every other slot 0.
+ */
+void SymbolTable::renumber() {
+    nextEpoch = 1;
+    for (Scope& scope : scopes) {
+        uint32_t epoch = nextEpoch++;
+        for (Slot& slot : scope.slots) {
+            slot.epoch = slot.epoch == scope.epoch ? epoch : 0;
+        }
+        scope.epoch = epoch;
+    }
+}
+
+/**
+ * Forget every variable, before parsing another class
+ * @param name The new class's name
+ */
+void SymbolTable::startClass(Atom name) {
+    depth = 0;
+    clear(scopes[0]);
+    className = name;
+}
+
+/**
+ * Open a scope for the arguments and locals of a subroutine
+ */
+void SymbolTable::pushScope() {
+    depth++;
+    if (depth == scopes.size()) {
+        scopes.emplace_back();
+    }
+    clear(scopes[depth]);
+}
+
+/**
+ * Close the innermost scope, forgetting its variables. The class scope is never closed.
+ */
+void SymbolTable::popScope() {
+    if (depth > 0) {
+        depth--;
+    }
+}
+
+/**
+ * Put a symbol in a scope's slots, which must have room
+ * @param scope The scope
+ * @param name The symbol's name
+ * @param symbol The symbol; replaces any earlier one of the same name
+ */
+void SymbolTable::insert(Scope& scope, Atom name, const Symbol& symbol) {
+    size_t mask = scope.slots.size() - 1;
+    size_t slot = slotOf(name, scope.slots.size());
+    while (scope.slots[slot].epoch == scope.epoch && scope.slots[slot].name != name) {
+        slot = (slot + 1) & mask;
+    }
+    if (scope.slots[slot].epoch != scope.epoch) {
+        scope.size++;
+    }
+    scope.slots[slot] = {name, scope.epoch, symbol};
+}
+
+/**
+ * Double a scope's slots, keeping the symbols of its current epoch
+ * @param scope The scope
+ */
+void SymbolTable::grow(Scope& scope) {
+    vector<Slot> old(max(FIRST_CAPACITY, scope.slots.size() * 2), Slot{0, 0, {}});
+    old.swap(scope.slots);
+    scope.size = 0;
+    for (const Slot& slot : old) {
+        if (slot.epoch == scope.epoch) {
+            insert(scope, slot.name, slot.symbol);
+        }
+    }
+}
+
+/**
+ * Declare a variable, giving it the next index of its kind.
+ * A second declaration of a name in the same scope replaces the first.
+ * @param name The variable's name
+ * @param type The variable's type
+ * @param kind Static or Field for the class scope, Argument or Local for the innermost scope
+ */
+void SymbolTable::define(Atom name, Atom type, SymbolKind kind) {
+    Scope& scope = kind == SymbolKind::Static || kind == SymbolKind::Field ? scopes[0] : scopes[depth];
+    if ((scope.size + 1) * 2 > scope.slots.size()) {
+        grow(scope);
+    }
+    insert(scope, name, {kind, type, scope.counts[(int) kind]++});
+}
+
+/**
+ * Find a name in one scope
+ * @return The symbol, or nullptr
+ */
+const Symbol* SymbolTable::find(const Scope& scope, Atom name) const {
+    if (scope.size == 0) {
+        return nullptr;
+    }
+    size_t mask = scope.slots.size() - 1;
+    size_t slot = slotOf(name, scope.slots.size());
+    while (scope.slots[slot].epoch == scope.epoch) {
+        if (scope.slots[slot].name == name) {
+            return &scope.slots[slot].symbol;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return nullptr;
+}
+
+/**
+ * Find a variable, looking in the innermost scope first
+ * @param name The variable's name
+ * @return The variable, or nullptr if no variable of that name is in scope,
+ *         e.g. because name is a class
+ */
+const Symbol* SymbolTable::lookup(Atom name) const {
+    for (size_t level = depth + 1; level-- > 0;) {
+        const Symbol* symbol = find(scopes[level], name);
+        if (symbol != nullptr) {
+            return symbol;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @param kind A kind of variable
+ * @return The number of variables of that kind declared so far in the scope
+ *         they go in: the class scope for Static and Field, the innermost
+ *         scope for Argument and Local
+ */
+uint32_t SymbolTable::count(SymbolKind kind) const {
+    const Scope& scope = kind == SymbolKind::Static || kind == SymbolKind::Field ? scopes[0] : scopes[depth];
+    return scope.counts[(int) kind];
+}
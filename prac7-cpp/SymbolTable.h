@@ -0,0 +1,83 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Interner.h"
+
+/**
+ * Where a Jack variable lives
+ */
+enum class SymbolKind : uint8_t {
+    Static, Field, Argument, Local
+};
+
+/**
+ * A declared variable
+ */
+struct Symbol {
+    SymbolKind kind;
+    Atom type;          // int, char, boolean or a class name
+    uint32_t index;     // position among the variables of the same kind in its scope
+};
+
+/**
+ * The variables in scope while one class is parsed, filled in by the parser
+ * as it reaches each declaration. Static and field variables go in the class
+ * scope; arguments and locals go in the innermost scope, and hide class
+ * variables of the same name.
+ *
+ * Each scope is an open-addressing hash table keyed by atom. A slot belongs
+ * to the table only if it carries the scope's current epoch, so a scope is
+ * emptied by bumping its epoch: pushing and popping a scope are O(1), and
+ * the slot arrays are reused from one subroutine to the next. When the
+ * 32-bit epochs run out, every slot is renumbered once.
+ */
+class SymbolTable {
+    private:
+        struct Slot {
+            Atom name;
+            uint32_t epoch;
+            Symbol symbol;
+        };
+
+        struct Scope {
+            std::vector<Slot> slots;    // empty, or a power of two in size
+            uint32_t epoch;
+            uint32_t size;
+            uint32_t counts[4];
+        };
+
+        // scopes[0] is the class scope; scopes past depth are kept for reuse
+        std::vector<Scope> scopes;
+        size_t depth;
+        uint32_t nextEpoch;
+        Atom className;
+
+        void clear(Scope& scope);
+        void renumber();
+        void insert(Scope& scope, Atom name, const Symbol& symbol);
+        void grow(Scope& scope);
+        const Symbol* find(const Scope& scope, Atom name) const;
+
+    public:
+        SymbolTable();
+
+        void startClass(Atom name);
+
+        void pushScope();
+
+        void popScope();
+
+        void define(Atom name, Atom type, SymbolKind kind);
+
+        const Symbol* lookup(Atom name) const;
+
+        uint32_t count(SymbolKind kind) const;
+
+        // the name of the class being parsed
+        Atom getClassName() const { return className; }
+};
+
+#endif /*SYMBOLTABLE_H*/
@@ -0,0 +1,144 @@
+#include "ThreadPool.h"
+
+using namespace std;
+
+/**
+ * Start the worker threads
+ * @param threads The number of workers, 0 for one per hardware thread
+ */
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    nextQueue = 0;
+    pending = 0;
+    stopping = false;
+
+    for (unsigned i = 0; i < threads; i++) {
+        queues.push_back(make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+/**
+ * Finish every submitted task, then stop the workers
+ */
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        lock_guard<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Queue a task. Tasks must not throw.
+ * @param task The task to run on some worker
+ */
+void ThreadPool::submit(function<void()> task) {
+    Queue& queue = *queues[nextQueue];
+    nextQueue = (nextQueue + 1) % queues.size();
+
+    pending++;
+    {
+        lock_guard<mutex> guard(queue.lock);
+        queue.tasks.push_back(move(task));
+    }
+    {
+        // taking the lock orders this wake-up after a worker's emptiness check
+        lock_guard<mutex> guard(sleepLock);
+    }
+    workAvailable.notify_one();
+}
+
+/**
+ * Block until every submitted task has finished
+ */
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(sleepLock);
+    allDone.wait(guard, [this] { return pending == 0; });
+}
+
+/**
+ * Get the number of worker threads
+ * @return The number of workers
+ */
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+/**
+ * Find a task for a worker: its own queue first, then the other queues
+ * @param self The worker's index
+ * @param task Set to the task found
+ * @return true if a task was found
+ */
+bool ThreadPool::take(size_t self, function<void()>& task) {
+    {
+        Queue& own = *queues[self];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size(); i++) {
+        Queue& victim = *queues[(self + i) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * The loop each worker thread runs
+ * @param self The worker's index
+ */
+void ThreadPool::work(size_t self) {
+    function<void()> task;
+
+    while (true) {
+        if (take(self, task)) {
+            task();
+            task = nullptr;
+            if (--pending == 0) {
+                lock_guard<mutex> guard(sleepLock);
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock<mutex> guard(sleepLock);
+        if (stopping) {
+            return;
+        }
+        // tasks submitted after take() failed are seen here, since submit() takes sleepLock
+        if (pending > 0) {
+            bool queued = false;
+            for (auto& queue : queues) {
+                lock_guard<mutex> queueGuard(queue->lock);
+                queued = queued || !queue->tasks.empty();
+            }
+            if (queued) {
+                continue;
+            }
+        }
+        workAvailable.wait(guard);
+    }
+}
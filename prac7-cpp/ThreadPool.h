@@ -0,0 +1,57 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads with one task queue each.
+ *
+ * Tasks are dealt out to the queues round-robin. A worker takes tasks from
+ * the front of its own queue, and when that is empty it steals from the
+ * back of another worker's queue. Submitting tasks largest first therefore
+ * runs the large tasks early and leaves the small ones for balancing.
+ */
+class ThreadPool {
+    private:
+        struct Queue {
+            std::mutex lock;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        size_t nextQueue;
+
+        // tasks submitted but not yet finished
+        std::atomic<size_t> pending;
+        bool stopping;
+
+        std::mutex sleepLock;
+        std::condition_variable workAvailable;
+        std::condition_variable allDone;
+
+        bool take(size_t self, std::function<void()>& task);
+        void work(size_t self);
+
+    public:
+        ThreadPool(unsigned threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()> task);
+
+        void wait();
+
+        size_t size() const;
+};
+
+#endif /*THREADPOOL_H*/
@@ -7,5 +7,15 @@ using namespace std;
  * @param value The token's value. Can be read using token.getValue()
  */
 Token::Token(string type, string value) : ParseTree(type, value) {
-    
-}
\ No newline at end of file
+    ParseTree::token = true;
+}
+
+/**
+ * Token for parsing. Can be used as a terminal node in a ParseTree
+ * @param kind The type of token (see token types). Can be read using token.getKind()
+ * @param value The token's interned value. Can be read using token.getAtom()
+ * @param memory Where the (always empty) list of children lives, see ParseTree
+ */
+Token::Token(NodeKind kind, Atom value, pmr::memory_resource* memory) : ParseTree(kind, value, memory) {
+    ParseTree::token = true;
+}
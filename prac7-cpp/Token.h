@@ -6,8 +6,19 @@
 #include "ParseTree.h"
 
 class Token : public ParseTree {
+    private:
+        Span where;
+
     public:
         Token(std::string type, std::string value);
+
+        Token(NodeKind kind, Atom value,
+              std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+        // where the Tokenizer found the token, unknown for tokens made any other way
+        Span getSpan() const { return where; }
+
+        void setSpan(Span span) { where = span; }
 };
 
-#endif /*TOKEN_H*/
\ No newline at end of file
+#endif /*TOKEN_H*/
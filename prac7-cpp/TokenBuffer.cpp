@@ -0,0 +1,53 @@
+#include "TokenBuffer.h"
+
+using namespace std;
+
+/**
+ * An empty TokenBuffer, holding just the end-of-input token
+ */
+TokenBuffer::TokenBuffer() {
+    arena = make_unique<Arena>();
+    tokens.push_back(arena->make<Token>(NodeKind::Eof, Atoms::Empty, arena.get()));
+}
+
+/**
+ * A TokenBuffer borrowing every token of a list
+ * @param tokens The tokens, in order
+ */
+TokenBuffer::TokenBuffer(const list<Token*>& tokens) : TokenBuffer() {
+    reserve(tokens.size());
+    for (Token* token : tokens) {
+        push(token);
+    }
+}
+
+/**
+ * Append a new token owned by this buffer
+ * @param kind The type of token
+ * @param value The token's value
+ * @return The new token
+ */
+Token* TokenBuffer::add(NodeKind kind, Atom value) {
+    Token* token = arena->make<Token>(kind, value, arena.get());
+    push(token);
+    return token;
+}
+
+/**
+ * Append a token owned by the caller
+ * @param token The token to append
+ */
+void TokenBuffer::push(Token* token) {
+    // the end-of-input token always stays last
+    Token* eof = tokens.back();
+    tokens.back() = token;
+    tokens.push_back(eof);
+}
+
+/**
+ * Make room for more tokens, so appending does not reallocate
+ * @param count The number of tokens expected in total
+ */
+void TokenBuffer::reserve(size_t count) {
+    tokens.reserve(count + 1);
+}
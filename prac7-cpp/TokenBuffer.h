@@ -0,0 +1,52 @@
+#ifndef TOKENBUFFER_H
+#define TOKENBUFFER_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "Arena.h"
+#include "Token.h"
+
+/**
+ * The input of a CompilerParser: tokens in one contiguous array, always
+ * followed by an end-of-input token (kind NodeKind::Eof), so the parser
+ * can look at the current token without checking bounds.
+ *
+ * Tokens made with add() are owned by the buffer and freed with it.
+ * Tokens handed over with push() are borrowed and must outlive the buffer.
+ */
+class TokenBuffer {
+    private:
+        std::unique_ptr<Arena> arena;
+        std::vector<Token*> tokens;
+
+    public:
+        TokenBuffer();
+        TokenBuffer(const std::list<Token*>& tokens);
+
+        TokenBuffer(TokenBuffer&&) = default;
+        TokenBuffer& operator=(TokenBuffer&&) = default;
+
+        Token* add(NodeKind kind, Atom value);
+        void push(Token* token);
+
+        void reserve(size_t count);
+
+        size_t size() const { return tokens.size() - 1; }
+
+        // the tokens made with add() and the array of pointers, for memory accounting
+        size_t bytesReserved() const {
+            return arena->bytesReserved() + tokens.capacity() * sizeof(Token*);
+        }
+
+        Token* operator[](size_t index) const { return tokens[index]; }
+
+        Token* const* begin() const { return tokens.data(); }
+
+        // the position of the end-of-input token
+        Token* const* end() const { return tokens.data() + tokens.size() - 1; }
+};
+
+#endif /*TOKENBUFFER_H*/
@@ -0,0 +1,299 @@
+#include "Tokenizer.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "CompilerParser.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+namespace {
+
+enum CharClass : uint8_t { OTHER, SPACE, LETTER, DIGIT, SYMBOL, QUOTE };
+
+const Atom NOT_A_KEYWORD = Atoms::Count;
+
+const size_t CACHE_SIZE = 1024;
+
+/**
+ * Lookup tables built once: the class of every byte, the atom of every
+ * symbol character, and a perfect hash table of the Jack keywords.
+ */
+struct Tables {
+    CharClass classes[256];
+    Atom symbols[256];
+    Atom keywords[32];
+    string_view keywordNames[32];
+
+    Tables() {
+        for (int c = 0; c < 256; c++) {
+            classes[c] = OTHER;
+            symbols[c] = Atoms::Empty;
+        }
+        for (int c = 'a'; c <= 'z'; c++) {
+            classes[c] = LETTER;
+            classes[c - 'a' + 'A'] = LETTER;
+        }
+        classes['_'] = LETTER;
+        for (int c = '0'; c <= '9'; c++) {
+            classes[c] = DIGIT;
+        }
+        classes[' '] = SPACE;
+        classes['\t'] = SPACE;
+        classes['\n'] = SPACE;
+        classes['\r'] = SPACE;
+        classes['"'] = QUOTE;
+
+        Interner& interner = Interner::global();
+        for (Atom atom = Atoms::LeftBrace; atom <= Atoms::Tilde; atom++) {
+            unsigned char c = (unsigned char) interner.str(atom)[0];
+            classes[c] = SYMBOL;
+            symbols[c] = atom;
+        }
+
+        for (int slot = 0; slot < 32; slot++) {
+            keywords[slot] = NOT_A_KEYWORD;
+        }
+        for (Atom atom = 0; atom < Atoms::KeywordCount; atom++) {
+            const string& name = interner.str(atom);
+            unsigned slot = hash(name.data(), name.size());
+            keywords[slot] = atom;
+            keywordNames[slot] = name;
+        }
+    }
+
+    /**
+     * Perfect hash of the 21 Jack keywords into 32 slots, found by search.
+     * Only valid for words of at least two characters.
+     */
+    static unsigned hash(const char* word, size_t length) {
+        return ((unsigned char) word[0] * 8u
+                + ((unsigned char) word[1] + (unsigned char) word[length - 1]) * 15u
+                + (unsigned) length) & 31u;
+    }
+
+    /**
+     * @return The keyword's atom, or NOT_A_KEYWORD
+     */
+    Atom keyword(const char* word, size_t length) const {
+        if (length < 2 || length > 11) {
+            return NOT_A_KEYWORD;
+        }
+        unsigned slot = hash(word, length);
+        const string_view& name = keywordNames[slot];
+        if (name.size() == length && memcmp(name.data(), word, length) == 0) {
+            return keywords[slot];
+        }
+        return NOT_A_KEYWORD;
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+/**
+ * Find the first byte that is not whitespace
+ * @return position, moved past any whitespace
+ */
+inline const char* skipSpace(const char* position, const char* limit, const CharClass* classes) {
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+
+    while (limit - position >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*) position);
+        __m128i isSpace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, carriageReturn)));
+        unsigned notSpace = ~(unsigned) _mm_movemask_epi8(isSpace) & 0xFFFFu;
+        if (notSpace != 0) {
+            return position + __builtin_ctz(notSpace);
+        }
+        position += 16;
+    }
+#endif
+    while (position < limit && classes[(unsigned char) *position] == SPACE) {
+        position++;
+    }
+    return position;
+}
+
+/**
+ * Make the span of some text in the source
+ * @param offset Where the text starts
+ * @param length Its size in bytes
+ * @return The span, or an unknown one if the text ends too far into the
+ *         source for a Span to hold
+ */
+inline Span spanOf(size_t offset, size_t length) {
+    if (offset + length >= Span::UNKNOWN) {
+        return Span();
+    }
+    return Span{(uint32_t) offset, (uint32_t) length};
+}
+
+}
+
+/**
+ * Constructor for a Tokenizer
+ * @param source The Jack source text. It is only read during tokenize().
+ */
+Tokenizer::Tokenizer(string_view source) {
+    this->source = source;
+    this->position = source.data();
+    this->limit = source.data() + source.size();
+
+    // Atoms::Empty is never looked up, so it marks an unused entry
+    this->cache.assign(CACHE_SIZE, CacheEntry{0, Atoms::Empty});
+}
+
+/**
+ * Intern a token's text, trying this tokenizer's cache before the shared Interner
+ * @param text The token's text
+ * @return The atom for text
+ */
+Atom Tokenizer::intern(string_view text) {
+    Interner& interner = Interner::global();
+    uint32_t h = Interner::hash(text);
+    CacheEntry& cached = cache[h & (CACHE_SIZE - 1)];
+
+    if (cached.hash == h && cached.atom != Atoms::Empty && interner.str(cached.atom) == text) {
+        return cached.atom;
+    }
+    cached.hash = h;
+    cached.atom = interner.intern(text);
+    return cached.atom;
+}
+
+/**
+ * Move past whitespace, // line comments and block comments
+ */
+void Tokenizer::skipSpaceAndComments() {
+    const CharClass* classes = tables().classes;
+
+    while (true) {
+        position = skipSpace(position, limit, classes);
+        if (limit - position < 2 || position[0] != '/') {
+            return;
+        }
+
+        if (position[1] == '/') {
+            const char* newline = (const char*) memchr(position, '\n', (size_t) (limit - position));
+            position = newline != nullptr ? newline + 1 : limit;
+        }
+        else if (position[1] == '*') {
+            // covers /** doc comments */ too
+            const char* search = position + 2;
+            while (true) {
+                const char* star = (const char*) memchr(search, '*', (size_t) (limit - search));
+                if (star == nullptr || star + 1 >= limit) {
+                    throw ParseException(); // unterminated comment
+                }
+                if (star[1] == '/') {
+                    position = star + 2;
+                    break;
+                }
+                search = star + 1;
+            }
+        }
+        else {
+            return;
+        }
+    }
+}
+
+/**
+ * Split the whole source into tokens. Each token's span is where it is in
+ * the source, quotes included for a string constant; the end-of-input
+ * token's is empty, at the end of the source. Spans are 32-bit, so tokens
+ * that end 4 GB or more into the source get an unknown span.
+ * @return The tokens, ready to be given to a CompilerParser
+ * @throws ParseException on text that is not a Jack token
+ */
+TokenBuffer Tokenizer::tokenize() {
+    const Tables& lookup = tables();
+
+    TokenBuffer tokens;
+    tokens.reserve(source.size() / 6);
+
+    skipSpaceAndComments();
+    while (position < limit) {
+        const char* start = position;
+        Token* token;
+
+        switch (lookup.classes[(unsigned char) *position]) {
+            case LETTER: {
+                do {
+                    position++;
+                } while (position < limit
+                         && (lookup.classes[(unsigned char) *position] == LETTER
+                             || lookup.classes[(unsigned char) *position] == DIGIT));
+
+                size_t length = (size_t) (position - start);
+                Atom keyword = lookup.keyword(start, length);
+                if (keyword != NOT_A_KEYWORD) {
+                    token = tokens.add(NodeKind::Keyword, keyword);
+                }
+                else {
+                    token = tokens.add(NodeKind::Identifier, intern(string_view(start, length)));
+                }
+                break;
+            }
+
+            case DIGIT: {
+                do {
+                    position++;
+                } while (position < limit && lookup.classes[(unsigned char) *position] == DIGIT);
+
+                token = tokens.add(NodeKind::IntegerConstant,
+                                   intern(string_view(start, (size_t) (position - start))));
+                break;
+            }
+
+            case QUOTE: {
+                const char* text = start + 1;
+                const char* quote = (const char*) memchr(text, '"', (size_t) (limit - text));
+                if (quote == nullptr || memchr(text, '\n', (size_t) (quote - text)) != nullptr) {
+                    throw ParseException(); // unterminated string constant
+                }
+                token = tokens.add(NodeKind::StringConstant,
+                                   intern(string_view(text, (size_t) (quote - text))));
+                position = quote + 1;
+                break;
+            }
+
+            case SYMBOL:
+                token = tokens.add(NodeKind::Symbol, lookup.symbols[(unsigned char) *position]);
+                position++;
+                break;
+
+            default:
+                throw ParseException(); // not the start of any token
+        }
+        token->setSpan(spanOf((size_t) (start - source.data()), (size_t) (position - start)));
+
+        skipSpaceAndComments();
+    }
+    tokens[tokens.size()]->setSpan(spanOf(source.size(), 0));
+
+    return tokens;
+}
+
+/**
+ * Map a .jack file and split it into tokens
+ * @param path The file to read
+ * @return The tokens, ready to be given to a CompilerParser
+ */
+TokenBuffer Tokenizer::tokenizeFile(const string& path) {
+    MappedFile file(path);
+    return Tokenizer(file.text()).tokenize();
+}
@@ -0,0 +1,44 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "TokenBuffer.h"
+
+/**
+ * Splits Jack source text into tokens for a CompilerParser.
+ *
+ * Token values are interned straight from the source text, so a value that
+ * has been seen before costs a hash lookup and no allocation. Whitespace and
+ * comments are skipped 16 bytes at a time where SSE2 is available.
+ * Each Tokenizer caches the atoms it has looked up, so tokenizers running
+ * on different threads rarely contend for the shared Interner.
+ */
+class Tokenizer {
+    private:
+        std::string_view source;
+        const char* position;
+        const char* limit;
+
+        struct CacheEntry {
+            uint32_t hash;
+            Atom atom;
+        };
+
+        // direct-mapped cache of atoms, indexed by the low bits of the hash
+        std::vector<CacheEntry> cache;
+
+        void skipSpaceAndComments();
+        Atom intern(std::string_view text);
+
+    public:
+        Tokenizer(std::string_view source);
+
+        TokenBuffer tokenize();
+
+        static TokenBuffer tokenizeFile(const std::string& path);
+};
+
+#endif /*TOKENIZER_H*/
@@ -0,0 +1,68 @@
+#include "TreeIndex.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+/**
+ * Index every node of a tree by kind and by value
+ * @param tree The tree to index, borrowed
+ */
+TreeIndex::TreeIndex(const FlatTree& tree) : tree(tree) {
+    // count the nodes of each kind, then deal them out in pre-order
+    size_t kindCount = (size_t) NodeKind::Count;
+    for (NodeId node = 0; node < tree.size(); node++) {
+        kindCount = max(kindCount, (size_t) tree.kind(node) + 1);
+    }
+    kindStarts.assign(kindCount + 1, 0);
+    for (NodeId node = 0; node < tree.size(); node++) {
+        kindStarts[(size_t) tree.kind(node) + 1]++;
+    }
+    for (size_t kind = 0; kind < kindCount; kind++) {
+        kindStarts[kind + 1] += kindStarts[kind];
+    }
+    kindNodes.resize(tree.size());
+    vector<size_t> next(kindStarts.begin(), kindStarts.end() - 1);
+    for (NodeId node = 0; node < tree.size(); node++) {
+        kindNodes[next[(size_t) tree.kind(node)]++] = node;
+    }
+
+    vector<pair<Atom, NodeId>> values;
+    for (NodeId node = 0; node < tree.size(); node++) {
+        if (tree.value(node) != Atoms::Empty) {
+            values.push_back({tree.value(node), node});
+        }
+    }
+    sort(values.begin(), values.end());
+    valueAtoms.reserve(values.size());
+    valueNodes.reserve(values.size());
+    for (const pair<Atom, NodeId>& value : values) {
+        valueAtoms.push_back(value.first);
+        valueNodes.push_back(value.second);
+    }
+}
+
+/**
+ * Find every node of one kind
+ * @param kind The type of node
+ * @return The nodes, in pre-order
+ */
+NodeRange TreeIndex::ofKind(NodeKind kind) const {
+    if ((size_t) kind + 1 >= kindStarts.size()) {
+        return NodeRange(nullptr, nullptr);
+    }
+    const NodeId* nodes = kindNodes.data();
+    return NodeRange(nodes + kindStarts[(size_t) kind], nodes + kindStarts[(size_t) kind + 1]);
+}
+
+/**
+ * Find every node with one value, e.g. each use of an identifier
+ * @param value The interned value
+ * @return The nodes, in pre-order
+ */
+NodeRange TreeIndex::withValue(Atom value) const {
+    auto found = equal_range(valueAtoms.begin(), valueAtoms.end(), value);
+    const NodeId* nodes = valueNodes.data();
+    return NodeRange(nodes + (found.first - valueAtoms.begin()), nodes + (found.second - valueAtoms.begin()));
+}
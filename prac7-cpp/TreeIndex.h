@@ -0,0 +1,57 @@
+#ifndef TREEINDEX_H
+#define TREEINDEX_H
+
+#include <cstddef>
+#include <vector>
+
+#include "FlatTree.h"
+
+/**
+ * A view of some of the NodeIds of an index, in pre-order
+ */
+class NodeRange {
+    private:
+        const NodeId* first;
+        const NodeId* last;
+
+    public:
+        NodeRange(const NodeId* first, const NodeId* last) : first(first), last(last) {}
+
+        const NodeId* begin() const { return first; }
+        const NodeId* end() const { return last; }
+
+        size_t size() const { return (size_t) (last - first); }
+        bool empty() const { return first == last; }
+};
+
+/**
+ * Finds the nodes of a FlatTree by kind and by value without walking it.
+ *
+ * Built in one pass over the tree, after which the nodes of one kind, or
+ * the leaves with one value (e.g. every use of an identifier), are a
+ * contiguous run of ids. Lookups cost time in the number of nodes found,
+ * not the size of the tree. The tree must outlive the index and not change.
+ */
+class TreeIndex {
+    private:
+        const FlatTree& tree;
+
+        // the nodes of kind k are kindNodes[kindStarts[k] .. kindStarts[k + 1])
+        std::vector<size_t> kindStarts;
+        std::vector<NodeId> kindNodes;
+
+        // nodes with a value other than Atoms::Empty, ordered by value, then by id
+        std::vector<Atom> valueAtoms;
+        std::vector<NodeId> valueNodes;
+
+    public:
+        TreeIndex(const FlatTree& tree);
+
+        const FlatTree& getTree() const { return tree; }
+
+        NodeRange ofKind(NodeKind kind) const;
+
+        NodeRange withValue(Atom value) const;
+};
+
+#endif /*TREEINDEX_H*/
@@ -0,0 +1,163 @@
+#include "TreeQuery.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+/**
+ * Find a node kind by its type name without adding new names
+ * @param name e.g. "whileStatement"
+ * @param kind Set to the kind if there is one
+ * @return true if name is the type name of a NodeKind
+ */
+static bool knownKind(string_view name, NodeKind& kind) {
+    for (size_t k = 0; k < (size_t) NodeKind::Count; k++) {
+        if (kindName((NodeKind) k) == name) {
+            kind = (NodeKind) k;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Compile a pattern
+ * @param pattern e.g. "ifStatement//whileStatement" or "doStatement/expression/term[draw]", see TreeQuery
+ * @throws runtime_error if the pattern is not valid
+ */
+TreeQuery::TreeQuery(string_view pattern) {
+    size_t i = 0;
+    bool descendant = false;
+    while (true) {
+        Step step{descendant, false, NodeKind::Count, false, Atoms::Empty};
+
+        size_t start = i;
+        while (i < pattern.size() && pattern[i] != '/' && pattern[i] != '[') {
+            i++;
+        }
+        string_view kind = pattern.substr(start, i - start);
+        if (kind == "*") {
+            step.anyKind = true;
+        }
+        else if (!knownKind(kind, step.kind)) {
+            throw runtime_error("unknown node kind '" + string(kind) + "' in pattern");
+        }
+
+        if (i < pattern.size() && pattern[i] == '[') {
+            size_t close = pattern.find(']', i);
+            if (close == string_view::npos || close == i + 1) {
+                throw runtime_error("expected a name and ']' in pattern");
+            }
+            step.named = true;
+            step.name = Interner::global().intern(pattern.substr(i + 1, close - i - 1));
+            i = close + 1;
+        }
+        steps.push_back(step);
+
+        if (i == pattern.size()) {
+            return;
+        }
+        if (pattern[i] != '/') {
+            throw runtime_error("expected '/' after ']' in pattern");
+        }
+        descendant = pattern.compare(i, 2, "//") == 0;
+        i += descendant ? 2 : 1;
+    }
+}
+
+/**
+ * Check one node against one step, ignoring the rest of the path
+ */
+bool TreeQuery::matchesStep(const FlatTree& tree, NodeId node, const Step& step) const {
+    if (!step.anyKind && tree.kind(node) != step.kind) {
+        return false;
+    }
+    if (!step.named || tree.value(node) == step.name) {
+        return true;
+    }
+    for (NodeId child : tree.children(node)) {
+        if (tree.value(child) == step.name && tree.firstChild(child) == NO_NODE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Check that the steps before one step match the ancestors of a node
+ * @param node A node already known to match steps[step]
+ * @param step The step node matches
+ * @param known The answers found so far for ancestors, by node and step,
+ *              so that with several // steps no ancestor is tried twice
+ */
+bool TreeQuery::matchesPath(const FlatTree& tree, NodeId node, size_t step,
+                            unordered_map<uint64_t, bool>& known) const {
+    if (step == 0) {
+        return true;
+    }
+    const Step& previous = steps[step - 1];
+    for (NodeId ancestor = tree.parent(node); ancestor != NO_NODE; ancestor = tree.parent(ancestor)) {
+        if (matchesStep(tree, ancestor, previous)) {
+            if (step - 1 == 0) {
+                return true;
+            }
+            uint64_t key = (uint64_t) ancestor * steps.size() + step - 1;
+            auto answer = known.find(key);
+            if (answer == known.end()) {
+                answer = known.emplace(key, matchesPath(tree, ancestor, step - 1, known)).first;
+            }
+            if (answer->second) {
+                return true;
+            }
+        }
+        if (!steps[step].descendant) {
+            break; // only the parent can match a / step
+        }
+    }
+    return false;
+}
+
+/**
+ * Find every node the pattern matches in an indexed tree
+ * @param index The tree's index
+ * @return The nodes matching the last step, in pre-order
+ */
+vector<NodeId> TreeQuery::find(const TreeIndex& index) const {
+    const FlatTree& tree = index.getTree();
+    const Step& last = steps.back();
+    vector<NodeId> found;
+    unordered_map<uint64_t, bool> known;
+
+    if (last.named) {
+        // a named node has the name itself or is the parent of a leaf that does
+        for (NodeId node : index.withValue(last.name)) {
+            if (matchesStep(tree, node, last) && matchesPath(tree, node, steps.size() - 1, known)) {
+                found.push_back(node);
+            }
+            NodeId parent = tree.parent(node);
+            if (parent != NO_NODE && tree.firstChild(node) == NO_NODE
+                && matchesStep(tree, parent, last) && matchesPath(tree, parent, steps.size() - 1, known)) {
+                found.push_back(parent);
+            }
+        }
+        sort(found.begin(), found.end());
+        found.erase(unique(found.begin(), found.end()), found.end());
+    }
+    else if (!last.anyKind) {
+        for (NodeId node : index.ofKind(last.kind)) {
+            if (matchesPath(tree, node, steps.size() - 1, known)) {
+                found.push_back(node);
+            }
+        }
+    }
+    else {
+        for (NodeId node = 0; node < tree.size(); node++) {
+            if (matchesPath(tree, node, steps.size() - 1, known)) {
+                found.push_back(node);
+            }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,56 @@
+#ifndef TREEQUERY_H
+#define TREEQUERY_H
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "TreeIndex.h"
+
+/**
+ * A structural pattern over parse trees, compiled once and matched against
+ * any number of indexed trees.
+ *
+ * A pattern is a path of steps from an outer node to the nodes it finds:
+ *
+ *     kind         a node of that kind, e.g. whileStatement; * for any kind
+ *     kind[name]   one that has value name, or has a leaf child with value name
+ *     A/B          a B that is a child of an A
+ *     A//B         a B anywhere inside an A
+ *
+ * A name only matches leaves and their parents, so the call in a do
+ * statement is found as the term holding the subroutine's name:
+ * "doStatement/expression/term[draw]" finds the terms that call draw (or
+ * x.draw) in do statements, and "ifStatement//whileStatement" every loop
+ * nested in an if. The first step may be anywhere in the tree.
+ *
+ * Matching starts from the index's nodes for the last step and checks the
+ * rest of the path by walking up parent links. Whether an ancestor matches
+ * the steps above it is worked out once per find(), so it costs time in the
+ * number of candidates times the depth of the tree times the number of
+ * steps, not the size of the tree.
+ */
+class TreeQuery {
+    private:
+        struct Step {
+            bool descendant;    // reached from the step before with //, not /
+            bool anyKind;
+            NodeKind kind;
+            bool named;
+            Atom name;
+        };
+
+        std::vector<Step> steps;
+
+        bool matchesStep(const FlatTree& tree, NodeId node, const Step& step) const;
+        bool matchesPath(const FlatTree& tree, NodeId node, size_t step,
+                         std::unordered_map<uint64_t, bool>& known) const;
+
+    public:
+        TreeQuery(std::string_view pattern);
+
+        std::vector<NodeId> find(const TreeIndex& index) const;
+};
+
+#endif /*TREEQUERY_H*/
@@ -0,0 +1,46 @@
+#include "TreeSink.h"
+
+using namespace std;
+
+/**
+ * A sink with an empty Arena
+ */
+TreeSink::TreeSink() {
+    this->arena = make_unique<Arena>();
+    this->lastLeft = nullptr;
+}
+
+/**
+ * Start a node around children that have already been built, which become
+ * its first children
+ * @param mark The position returned by mark() before the first of those children
+ * @param kind The type of node
+ */
+void TreeSink::wrap(size_t mark, NodeKind kind) {
+    ParseTree* node = arena->make<ParseTree>(kind, Atoms::Empty, arena.get());
+    if (openNodes.empty()) {
+        // the parser was called directly, outside any other production
+        node->addChild(lastLeft);
+    }
+    else {
+        ParseTree* parent = openNodes.back();
+        ChildRange children = parent->getChildren();
+        for (size_t i = mark; i < children.size(); i++) {
+            node->addChild(children[i]);
+        }
+        parent->removeChildren(mark);
+    }
+    openNodes.push_back(node);
+}
+
+/**
+ * Hand over the nodes built so far, and start a fresh Arena for the next tree
+ * @param root The tree to release, as returned by one of the compile methods
+ * @return A ParseResult that owns every node the sink allocated
+ */
+ParseResult TreeSink::release(ParseTree* root) {
+    ParseResult result(move(arena), root);
+    arena = make_unique<Arena>();
+    openNodes.clear(); // left behind if a ParseException stopped a compile method
+    return result;
+}
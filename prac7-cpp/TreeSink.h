@@ -0,0 +1,62 @@
+#ifndef TREESINK_H
+#define TREESINK_H
+
+#include <memory>
+#include <vector>
+
+#include "Arena.h"
+#include "ParseResult.h"
+#include "ParseTree.h"
+#include "Token.h"
+
+/**
+ * The BasicParser Sink that builds ParseTrees. Nodes are allocated in an
+ * Arena owned by the sink until release() hands them over.
+ */
+class TreeSink {
+    private:
+        std::unique_ptr<Arena> arena;
+
+        // nodes started by enter() and not yet finished, innermost last
+        std::vector<ParseTree*> openNodes;
+        ParseTree* lastLeft;
+
+    public:
+        TreeSink();
+
+        // start a node; tokens and finished nodes become its children until leave()
+        void enter(NodeKind kind) {
+            openNodes.push_back(arena->make<ParseTree>(kind, Atoms::Empty, arena.get()));
+        }
+
+        void token(Token* token) { openNodes.back()->addChild(token); }
+
+        Token* makeToken(NodeKind kind, Atom value) {
+            return arena->make<Token>(kind, value, arena.get());
+        }
+
+        // the position the next child of the innermost node will have
+        size_t mark() const {
+            return openNodes.empty() ? 0 : openNodes.back()->getChildren().size();
+        }
+
+        void wrap(size_t mark, NodeKind kind);
+
+        // finish the innermost node and add it to its parent
+        ParseTree* leave() {
+            ParseTree* node = openNodes.back();
+            openNodes.pop_back();
+            if (!openNodes.empty()) {
+                openNodes.back()->addChild(node);
+            }
+            lastLeft = node;
+            return node;
+        }
+
+        // the Arena the nodes built so far are in
+        Arena& getArena() { return *arena; }
+
+        ParseResult release(ParseTree* root);
+};
+
+#endif /*TREESINK_H*/
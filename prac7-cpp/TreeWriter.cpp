@@ -0,0 +1,245 @@
+#include "TreeWriter.h"
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedTree.h"
+
+using namespace std;
+
+namespace {
+
+// a node whose children are being written, and the next child to write
+struct Frame {
+    const ParseTree* node;
+    size_t next;
+    int depth;
+};
+
+const string_view TEXT_INDENT = "  \u2502 ";
+const string_view TEXT_BRANCH = "  \u2514 ";
+
+/**
+ * Write a node's value with the characters XML reserves escaped
+ */
+void writeEscaped(const string& value, OutputBuffer& out) {
+    size_t start = 0;
+    for (size_t i = 0; i < value.size(); i++) {
+        string_view replacement;
+        switch (value[i]) {
+            case '<': replacement = "&lt;"; break;
+            case '>': replacement = "&gt;"; break;
+            case '&': replacement = "&amp;"; break;
+            case '"': replacement = "&quot;"; break;
+            default: continue;
+        }
+        out.write(value.data() + start, i - start);
+        out.write(replacement);
+        start = i + 1;
+    }
+    out.write(value.data() + start, value.size() - start);
+}
+
+/**
+ * The element name nand2tetris uses for a kind
+ */
+const string& xmlName(NodeKind kind) {
+    static const string subroutineDec = "subroutineDec";
+    if (kind == NodeKind::Subroutine) {
+        return subroutineDec;
+    }
+    return kindName(kind);
+}
+
+void writeSpaces(int count, OutputBuffer& out) {
+    for (int i = 0; i < count; i++) {
+        out.write("  ", 2);
+    }
+}
+
+}
+
+/**
+ * Write a tree in the box-drawing format of ParseTree::tostring()
+ * @param root The tree to write
+ * @param out Where to write it
+ * @param depth The indentation level of the root
+ */
+void TreeWriter::writeText(const ParseTree* root, OutputBuffer& out, int depth) {
+    vector<Frame> stack;
+    const ParseTree* node = root;
+
+    while (true) {
+        // write the node's own line, and start on its children if it has any
+        if (node != nullptr) {
+            out.write(node->getType());
+            if (node->getChildren().empty()) {
+                out.put(' ');
+                out.write(node->getValue());
+                out.put('\n');
+            }
+            else {
+                out.put('\n');
+                stack.push_back({node, 0, depth});
+            }
+            node = nullptr;
+        }
+
+        if (stack.empty()) {
+            return;
+        }
+
+        Frame& frame = stack.back();
+        ChildRange children = frame.node->getChildren();
+        for (int i = 0; i < frame.depth; i++) {
+            out.write(TEXT_INDENT);
+        }
+        if (frame.next < children.size()) {
+            out.write(TEXT_BRANCH);
+            node = children[frame.next++];
+            depth = frame.depth + 1;
+        }
+        else {
+            out.put('\n');
+            stack.pop_back();
+        }
+    }
+}
+
+/**
+ * Write a tree as nand2tetris XML. binaryExpression nodes are flattened into
+ * their expression, giving the standard term (op term)* form.
+ * @param root The tree to write
+ * @param out Where to write it
+ */
+void TreeWriter::writeXml(const ParseTree* root, OutputBuffer& out) {
+    vector<Frame> stack;
+    const ParseTree* node = root;
+    int depth = 0;
+
+    while (true) {
+        if (node != nullptr) {
+            if (node->getKind() == NodeKind::BinaryExpression) {
+                // no element of its own, its children go straight into the parent
+                stack.push_back({node, 0, depth});
+            }
+            else if (node->getKind() < NodeKind::Eof
+                     || (node->getKind() >= NodeKind::Count && node->getChildren().empty())) {
+                // terminal: <keyword> class </keyword>
+                writeSpaces(depth, out);
+                out.put('<');
+                out.write(xmlName(node->getKind()));
+                out.write("> ", 2);
+                writeEscaped(node->getValue(), out);
+                out.write(" </", 3);
+                out.write(xmlName(node->getKind()));
+                out.write(">\n", 2);
+            }
+            else {
+                writeSpaces(depth, out);
+                out.put('<');
+                out.write(xmlName(node->getKind()));
+                out.write(">\n", 2);
+                stack.push_back({node, 0, depth + 1});
+            }
+            node = nullptr;
+        }
+
+        if (stack.empty()) {
+            return;
+        }
+
+        Frame& frame = stack.back();
+        ChildRange children = frame.node->getChildren();
+        if (frame.next < children.size()) {
+            node = children[frame.next++];
+            depth = frame.depth;
+            continue;
+        }
+
+        if (frame.node->getKind() != NodeKind::BinaryExpression) {
+            writeSpaces(frame.depth - 1, out);
+            out.write("</", 2);
+            out.write(xmlName(frame.node->getKind()));
+            out.write(">\n", 2);
+        }
+        stack.pop_back();
+    }
+}
+
+/**
+ * Write a tree in the binary format read by MappedTree. Nodes are
+ * renumbered breadth-first so that each node's children are contiguous,
+ * and values and kind names are stored once each in a string table.
+ * @param tree The tree to write, which must not be empty
+ * @param out Where to write it
+ */
+void TreeWriter::writeBinary(const FlatTree& tree, OutputBuffer& out) {
+    using namespace BinaryFormat;
+
+    vector<NodeId> order;
+    order.reserve(tree.size());
+    order.push_back(0);
+    for (size_t i = 0; i < order.size(); i++) {
+        for (NodeId child : tree.children(order[i])) {
+            order.push_back(child);
+        }
+    }
+
+    vector<const string*> strings;
+    unordered_map<Atom, uint32_t> valueIndex;
+    vector<uint32_t> kindTable;
+    unordered_map<uint16_t, uint16_t> kindIndex;
+    uint32_t dataSize = 0;
+
+    auto addString = [&](const string& text) {
+        strings.push_back(&text);
+        dataSize += (uint32_t) text.size() + 1;
+        return (uint32_t) strings.size() - 1;
+    };
+
+    vector<Node> nodes(order.size());
+    uint32_t nextChild = 1;
+    for (size_t i = 0; i < order.size(); i++) {
+        NodeId id = order[i];
+        Node& node = nodes[i];
+
+        auto kind = kindIndex.find((uint16_t) tree.kind(id));
+        if (kind == kindIndex.end()) {
+            kindTable.push_back(addString(kindName(tree.kind(id))));
+            kind = kindIndex.emplace((uint16_t) tree.kind(id), (uint16_t) (kindTable.size() - 1)).first;
+        }
+        auto value = valueIndex.find(tree.value(id));
+        if (value == valueIndex.end()) {
+            value = valueIndex.emplace(tree.value(id), addString(Interner::global().str(tree.value(id)))).first;
+        }
+
+        node.kind = kind->second;
+        node.reserved = 0;
+        node.value = value->second;
+        node.firstChild = nextChild;
+        node.childCount = 0;
+        for (NodeId child : tree.children(id)) {
+            (void) child;
+            node.childCount++;
+        }
+        nextChild += node.childCount;
+    }
+
+    Header header = {MAGIC, VERSION, (uint32_t) nodes.size(), (uint32_t) kindTable.size(),
+                     (uint32_t) strings.size(), dataSize, {0, 0}};
+    out.write((const char*) &header, sizeof(header));
+    out.write((const char*) nodes.data(), nodes.size() * sizeof(Node));
+    out.write((const char*) kindTable.data(), kindTable.size() * sizeof(uint32_t));
+
+    uint32_t offset = 0;
+    for (const string* text : strings) {
+        String entry = {offset, (uint32_t) text->size()};
+        out.write((const char*) &entry, sizeof(entry));
+        offset += entry.length + 1;
+    }
+    for (const string* text : strings) {
+        out.write(text->data(), text->size() + 1);
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef TREEWRITER_H
+#define TREEWRITER_H
+
+#include "FlatTree.h"
+#include "OutputBuffer.h"
+#include "ParseTree.h"
+
+/**
+ * Serializes parse trees in one pass into an OutputBuffer.
+ * Nodes are visited with an explicit stack, so neither the depth of the
+ * tree nor the size of the output is limited by the native stack or by
+ * holding the whole text in memory.
+ */
+class TreeWriter {
+    public:
+        static void writeText(const ParseTree* root, OutputBuffer& out, int depth = 0);
+
+        static void writeXml(const ParseTree* root, OutputBuffer& out);
+
+        static void writeBinary(const FlatTree& tree, OutputBuffer& out);
+};
+
+#endif /*TREEWRITER_H*/
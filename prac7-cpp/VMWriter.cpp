@@ -0,0 +1,153 @@
+#include "VMWriter.h"
+
+using namespace std;
+
+// names of the segments, in the order of Segment
+static const string_view SEGMENT_NAMES[] = {
+    "constant", "argument", "local", "static", "this", "that", "pointer", "temp"
+};
+
+/**
+ * A writer that appends commands to a buffer
+ * @param out Where the commands go, borrowed
+ */
+VMWriter::VMWriter(OutputBuffer& out) : out(out) {
+
+}
+
+/**
+ * Write a number in decimal
+ * @param number The number
+ */
+void VMWriter::writeNumber(uint32_t number) {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = (char) ('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+    while (count > 0) {
+        out.put(digits[--count]);
+    }
+}
+
+/**
+ * Write " segment index\n", the end of a push or pop
+ */
+void VMWriter::writeSegment(Segment segment, uint32_t index) {
+    out.put(' ');
+    out.write(SEGMENT_NAMES[(int) segment]);
+    out.put(' ');
+    writeNumber(index);
+    out.put('\n');
+}
+
+/**
+ * Write the full name of a subroutine, e.g. Main.main
+ */
+void VMWriter::writeName(string_view className, string_view name) {
+    out.write(className);
+    out.put('.');
+    out.write(name);
+}
+
+/**
+ * Write a push command
+ * @param segment The segment to read from
+ * @param index The position in the segment, or the value for Segment::Constant
+ */
+void VMWriter::writePush(Segment segment, uint32_t index) {
+    out.write("push");
+    writeSegment(segment, index);
+}
+
+/**
+ * Write a pop command
+ * @param segment The segment to write to
+ * @param index The position in the segment
+ */
+void VMWriter::writePop(Segment segment, uint32_t index) {
+    out.write("pop");
+    writeSegment(segment, index);
+}
+
+/**
+ * Write an arithmetic or logical command
+ * @param command add, sub, neg, eq, gt, lt, and, or or not
+ */
+void VMWriter::writeArithmetic(string_view command) {
+    out.write(command);
+    out.put('\n');
+}
+
+/**
+ * Write a label command. Labels are made of a prefix and a number unique
+ * within the subroutine, e.g. WHILE_EXP0.
+ * @param prefix The label's prefix
+ * @param number The label's number
+ */
+void VMWriter::writeLabel(string_view prefix, uint32_t number) {
+    out.write("label ");
+    out.write(prefix);
+    writeNumber(number);
+    out.put('\n');
+}
+
+/**
+ * Write an unconditional jump to a label
+ * @param prefix The label's prefix
+ * @param number The label's number
+ */
+void VMWriter::writeGoto(string_view prefix, uint32_t number) {
+    out.write("goto ");
+    out.write(prefix);
+    writeNumber(number);
+    out.put('\n');
+}
+
+/**
+ * Write a jump to a label, taken if the value popped off the stack is not false
+ * @param prefix The label's prefix
+ * @param number The label's number
+ */
+void VMWriter::writeIf(string_view prefix, uint32_t number) {
+    out.write("if-goto ");
+    out.write(prefix);
+    writeNumber(number);
+    out.put('\n');
+}
+
+/**
+ * Write a call command
+ * @param className The class the subroutine belongs to
+ * @param name The subroutine's name
+ * @param argumentCount The number of arguments pushed, including the object for a method
+ */
+void VMWriter::writeCall(string_view className, string_view name, uint32_t argumentCount) {
+    out.write("call ");
+    writeName(className, name);
+    out.put(' ');
+    writeNumber(argumentCount);
+    out.put('\n');
+}
+
+/**
+ * Write the start of a subroutine
+ * @param className The class being compiled
+ * @param name The subroutine's name
+ * @param localCount The number of local variables it declares
+ */
+void VMWriter::writeFunction(string_view className, string_view name, uint32_t localCount) {
+    out.write("function ");
+    writeName(className, name);
+    out.put(' ');
+    writeNumber(localCount);
+    out.put('\n');
+}
+
+/**
+ * Write a return command
+ */
+void VMWriter::writeReturn() {
+    out.write("return\n");
+}
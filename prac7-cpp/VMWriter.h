@@ -0,0 +1,50 @@
+#ifndef VMWRITER_H
+#define VMWRITER_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "OutputBuffer.h"
+
+/**
+ * A memory segment of the Hack virtual machine
+ */
+enum class Segment : uint8_t {
+    Constant, Argument, Local, Static, This, That, Pointer, Temp
+};
+
+/**
+ * Writes Hack VM commands, one per line, into an OutputBuffer.
+ * Numbers are formatted in place, so no command allocates.
+ */
+class VMWriter {
+    private:
+        OutputBuffer& out;
+
+        void writeNumber(uint32_t number);
+        void writeSegment(Segment segment, uint32_t index);
+        void writeName(std::string_view className, std::string_view name);
+
+    public:
+        VMWriter(OutputBuffer& out);
+
+        void writePush(Segment segment, uint32_t index);
+
+        void writePop(Segment segment, uint32_t index);
+
+        void writeArithmetic(std::string_view command);
+
+        void writeLabel(std::string_view prefix, uint32_t number);
+
+        void writeGoto(std::string_view prefix, uint32_t number);
+
+        void writeIf(std::string_view prefix, uint32_t number);
+
+        void writeCall(std::string_view className, std::string_view name, uint32_t argumentCount);
+
+        void writeFunction(std::string_view className, std::string_view name, uint32_t localCount);
+
+        void writeReturn();
+};
+
+#endif /*VMWRITER_H*/
@@ -0,0 +1,33 @@
+#ifndef VALIDATESINK_H
+#define VALIDATESINK_H
+
+#include "ParseTree.h"
+#include "Token.h"
+
+/**
+ * The BasicParser Sink for checking that input parses, and nothing more.
+ * Every event is empty, so the specialized parser allocates nothing and
+ * its compile methods return nullptr. In recovery mode every error token
+ * is the same placeholder.
+ */
+class ValidateSink {
+    private:
+        Token placeholder;
+
+    public:
+        ValidateSink() : placeholder(NodeKind::Error, Atoms::Empty) {}
+
+        void enter(NodeKind) {}
+
+        void token(Token*) {}
+
+        Token* makeToken(NodeKind, Atom) { return &placeholder; }
+
+        size_t mark() const { return 0; }
+
+        void wrap(size_t, NodeKind) {}
+
+        ParseTree* leave() { return nullptr; }
+};
+
+#endif /*VALIDATESINK_H*/
@@ -0,0 +1,380 @@
+/*
+ * Parser benchmarks over a generated Jack corpus.
+ *
+ * Build from prac7-cpp with every parser source except Main.cpp:
+ *   g++ -std=c++17 -O2 -pthread bench/Benchmark.cpp bench/JackGenerator.cpp $(ls *.cpp | grep -v -e Main.cpp -e example.cpp) -o benchmark
+ *
+ * Usage: benchmark [--bytes N] [--depth N] [--density X] [--seed N]
+ *                  [--iterations N] [--corpus FILE] [--write-corpus FILE] [--json]
+ *
+ * --corpus benchmarks compileClass on an existing file instead of a generated one,
+ * --write-corpus writes the generated class to a file and exits (sizes up to GB),
+ * --json prints one JSON document to diff between versions instead of a table.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "JackGenerator.h"
+#include "../CompilerParser.h"
+#include "../FlatTree.h"
+#include "../HashConsSink.h"
+#include "../IncrementalParser.h"
+#include "../MappedFile.h"
+#include "../ThreadPool.h"
+#include "../Tokenizer.h"
+#include "../TreeQuery.h"
+#include "../ValidateSink.h"
+
+using namespace std;
+
+// every allocation the program makes goes through these counters
+static atomic<uint64_t> allocations(0);
+static atomic<uint64_t> allocatedBytes(0);
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    allocatedBytes.fetch_add(size, memory_order_relaxed);
+    void* pointer = malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+        throw bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+namespace {
+
+/**
+ * The outcome of one benchmark, averaged over its iterations
+ */
+struct Measurement {
+    string name;
+    uint64_t bytes = 0;
+    uint64_t tokens = 0;
+    uint64_t nodes = 0;
+    int iterations = 0;
+    double seconds = 0;        // fastest iteration
+    double allocations = 0;    // per iteration
+    double allocatedBytes = 0; // per iteration
+    long peakRssKb = 0;
+};
+
+/**
+ * Start measuring peak memory from the current usage, where the system allows it
+ */
+void resetPeakRss() {
+#ifdef __linux__
+    ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+#endif
+}
+
+/**
+ * Get the most memory the process has held since resetPeakRss(), or since it started
+ * @return The peak resident set size in KB
+ */
+long peakRssKb() {
+#ifdef __linux__
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return atol(line.c_str() + 6);
+        }
+    }
+#endif
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Run one benchmark. run() is timed, and returns the number of nodes it built.
+ */
+Measurement measure(const string& name, uint64_t bytes, uint64_t tokens, int iterations,
+                    const function<uint64_t()>& run) {
+    Measurement result;
+    result.name = name;
+    result.bytes = bytes;
+    result.tokens = tokens;
+    result.iterations = iterations;
+    result.seconds = 1e300;
+
+    resetPeakRss();
+    uint64_t startAllocations = allocations.load();
+    uint64_t startBytes = allocatedBytes.load();
+
+    for (int i = 0; i < iterations; i++) {
+        auto start = chrono::steady_clock::now();
+        result.nodes = run();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        result.seconds = min(result.seconds, seconds);
+    }
+
+    result.allocations = (double) (allocations.load() - startAllocations) / iterations;
+    result.allocatedBytes = (double) (allocatedBytes.load() - startBytes) / iterations;
+    result.peakRssKb = peakRssKb();
+    return result;
+}
+
+uint64_t countNodes(const ParseTree* root) {
+    return FlatTree(root).size();
+}
+
+/**
+ * Benchmark tokenizing and one compile method on the given source
+ */
+void benchmarkProduction(vector<Measurement>& results, const string& name, const string& source,
+                         int iterations, const function<ParseTree*(CompilerParser&)>& compile) {
+    TokenBuffer tokens = Tokenizer(source).tokenize();
+    results.push_back(measure(name, source.size(), tokens.size(), iterations, [&] {
+        CompilerParser parser(tokens);
+        ParseResult tree = parser.release(compile(parser));
+        return countNodes(tree.getRoot());
+    }));
+}
+
+void printTable(const vector<Measurement>& results) {
+    printf("%-28s %12s %12s %14s %14s %12s %10s\n",
+           "benchmark", "ms", "MB/s", "tokens/s", "nodes/s", "allocs", "peak KB");
+    for (const Measurement& m : results) {
+        printf("%-28s %12.3f %12.1f %14.0f %14.0f %12.0f %10ld\n",
+               m.name.c_str(), m.seconds * 1000, m.bytes / m.seconds / 1e6,
+               m.tokens / m.seconds, m.nodes / m.seconds, m.allocations, m.peakRssKb);
+    }
+}
+
+void printJson(const vector<Measurement>& results, const GeneratorOptions& options) {
+    printf("{\n  \"corpus\": {\"bytes\": %llu, \"depth\": %d, \"expressionDensity\": %g, \"seed\": %u},\n",
+           (unsigned long long) options.bytes, options.depth, options.expressionDensity, options.seed);
+    printf("  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Measurement& m = results[i];
+        printf("    {\"name\": \"%s\", \"iterations\": %d, \"bytes\": %llu, \"tokens\": %llu, \"nodes\": %llu, "
+               "\"seconds\": %.9f, \"tokensPerSecond\": %.0f, \"nodesPerSecond\": %.0f, "
+               "\"allocations\": %.0f, \"allocatedBytes\": %.0f, \"peakRssKb\": %ld}%s\n",
+               m.name.c_str(), m.iterations, (unsigned long long) m.bytes, (unsigned long long) m.tokens,
+               (unsigned long long) m.nodes, m.seconds, m.tokens / m.seconds, m.nodes / m.seconds,
+               m.allocations, m.allocatedBytes, m.peakRssKb, i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorOptions options;
+    int iterations = 5;
+    string corpus;
+    string writeCorpus;
+    bool json = false;
+
+    for (int i = 1; i < argc; i++) {
+        string flag = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (flag == "--bytes" && hasValue) {
+            options.bytes = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (flag == "--depth" && hasValue) {
+            options.depth = atoi(argv[++i]);
+        }
+        else if (flag == "--density" && hasValue) {
+            options.expressionDensity = atof(argv[++i]);
+        }
+        else if (flag == "--seed" && hasValue) {
+            options.seed = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if (flag == "--iterations" && hasValue) {
+            iterations = max(1, atoi(argv[++i]));
+        }
+        else if (flag == "--corpus" && hasValue) {
+            corpus = argv[++i];
+        }
+        else if (flag == "--write-corpus" && hasValue) {
+            writeCorpus = argv[++i];
+        }
+        else if (flag == "--json") {
+            json = true;
+        }
+        else {
+            cerr << "unknown option " << flag << endl;
+            return 1;
+        }
+    }
+
+#ifndef _WIN32
+    if (!writeCorpus.empty()) {
+        int fd = open(writeCorpus.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            cerr << "cannot write " << writeCorpus << endl;
+            return 1;
+        }
+        OutputBuffer out(fd);
+        JackGenerator(options).write(out);
+        close(fd);
+        return 0;
+    }
+#endif
+
+    vector<Measurement> results;
+    try {
+        string source;
+        if (!corpus.empty()) {
+            MappedFile file(corpus);
+            source = string(file.text());
+        }
+        else {
+            source = JackGenerator(options).generate(Production::Class);
+        }
+
+        uint64_t tokenCount = Tokenizer(source).tokenize().size();
+        results.push_back(measure("tokenize", source.size(), tokenCount, iterations, [&] {
+            Tokenizer(source).tokenize();
+            return (uint64_t) 0;
+        }));
+
+        benchmarkProduction(results, "compileClass", source, iterations,
+                            [](CompilerParser& parser) { return parser.compileClass(); });
+        benchmarkProduction(results, "compileClass/explicitStack", source, iterations,
+                            [](CompilerParser& parser) {
+                                parser.setMode(ParseMode::ExplicitStack);
+                                return parser.compileClass();
+                            });
+        benchmarkProduction(results, "compileClass/recovery", source, iterations,
+                            [](CompilerParser& parser) {
+                                parser.setRecovery(true);
+                                return parser.compileClass();
+                            });
+        ThreadPool pool;
+        benchmarkProduction(results, "compileClass/parallel", source, iterations,
+                            [&pool](CompilerParser& parser) { return parser.compileClassParallel(pool); });
+        benchmarkProduction(results, "compileClass/lazy", source, iterations,
+                            [](CompilerParser& parser) {
+                                parser.setLazy(true);
+                                return parser.compileClass();
+                            });
+
+        TokenBuffer tokens = Tokenizer(source).tokenize();
+        results.push_back(measure("compileClass/validate", source.size(), tokens.size(), iterations, [&] {
+            BasicParser<ValidateSink> validator(tokens);
+            validator.compileClass();
+            return (uint64_t) 0;
+        }));
+
+        results.push_back(measure("compileClass/shared", source.size(), tokens.size(), iterations, [&] {
+            BasicParser<HashConsSink> parser(tokens);
+            ParseResult tree = parser.sink.release(parser.compileClass());
+            return countNodes(tree.getRoot());
+        }));
+
+        CompilerParser parser(tokens);
+        ParseResult tree = parser.release(parser.compileClass());
+        uint64_t nodes = countNodes(tree.getRoot());
+        results.push_back(measure("tostring", source.size(), tokens.size(), iterations, [&] {
+            tree.getRoot()->tostring();
+            return nodes;
+        }));
+
+        // the same question answered by scanning every node, and through an index built once
+        FlatTree flat(tree.getRoot());
+        TreeIndex index(flat);
+        TreeQuery nestedLoops("ifStatement//whileStatement");
+        results.push_back(measure("query/scan", source.size(), tokens.size(), iterations, [&] {
+            uint64_t found = 0;
+            flat.preorder(0, [&](NodeId node) {
+                if (flat.kind(node) != NodeKind::WhileStatement) {
+                    return;
+                }
+                for (NodeId ancestor = flat.parent(node); ancestor != NO_NODE; ancestor = flat.parent(ancestor)) {
+                    if (flat.kind(ancestor) == NodeKind::IfStatement) {
+                        found++;
+                        break;
+                    }
+                }
+            });
+            return found;
+        }));
+        results.push_back(measure("query/indexed", source.size(), tokens.size(), iterations, [&] {
+            return (uint64_t) nestedLoops.find(index).size();
+        }));
+
+        // a keystroke in the first subroutine and its undo, reading the span of
+        // the whole class after each, which moves with every child after it
+        IncrementalParser incremental(source);
+        const ParseTree* first = nullptr;
+        for (const ParseTree* child : incremental.getRoot()->getChildren()) {
+            if (first == nullptr && child->getKind() == NodeKind::Subroutine) {
+                first = child;
+            }
+        }
+        if (first != nullptr) {
+            size_t offset = incremental.span(first).end() - 1;
+            results.push_back(measure("incremental/edit", source.size(), tokens.size(), iterations, [&] {
+                incremental.edit(offset, 0, " ");
+                incremental.span(incremental.getRoot());
+                incremental.edit(offset, 1, "");
+                incremental.span(incremental.getRoot());
+                return (uint64_t) 0;
+            }));
+        }
+
+        if (corpus.empty()) {
+            GeneratorOptions narrower = options;
+            narrower.bytes = max<uint64_t>(options.bytes / 4, 1024);
+            JackGenerator generator(narrower);
+
+            benchmarkProduction(results, "compileSubroutine", generator.generate(Production::Subroutine),
+                                iterations, [](CompilerParser& parser) { return parser.compileSubroutine(); });
+            benchmarkProduction(results, "compileStatements", generator.generate(Production::Statements),
+                                iterations, [](CompilerParser& parser) { return parser.compileStatements(); });
+            benchmarkProduction(results, "compileExpression", generator.generate(Production::Expression),
+                                iterations, [](CompilerParser& parser) { return parser.compileExpression(); });
+
+            // short expressions, so the time goes on choosing and starting statements
+            GeneratorOptions dense = narrower;
+            dense.expressionDensity = 0;
+            benchmarkProduction(results, "compileStatements/dense", JackGenerator(dense).generate(Production::Statements),
+                                iterations, [](CompilerParser& parser) { return parser.compileStatements(); });
+        }
+    } catch (ParseException& e) {
+        cerr << "the corpus does not parse" << endl;
+        return 1;
+    } catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (json) {
+        printJson(results, options);
+    }
+    else {
+        printTable(results);
+    }
+    return 0;
+}
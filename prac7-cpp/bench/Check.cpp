@@ -0,0 +1,997 @@
+/*
+ * Differential checks of the parser: the same input is parsed two ways that
+ * must agree, over many randomly damaged copies of a generated class.
+ *
+ * Build from prac7-cpp like the benchmarks:
+ *   g++ -std=c++17 -O2 -pthread bench/Check.cpp bench/JackGenerator.cpp $(ls *.cpp | grep -v -e Main.cpp -e example.cpp) -o check
+ *
+ * Usage: check [--bytes N] [--seed N] [--iterations N] [--corpus FILE] [CHECK...]
+ *
+ * Runs the named checks, or all of them, and prints one line for each. The
+ * exit status is 1 if any check found a difference. The same options always
+ * make the same inputs, so a failure can be run again.
+ *
+ *   recovery   token streams with tokens dropped and repeated: the explicit
+ *              stack parse builds the same tree and errors as the recursive
+ *              one, and recovery reports errors exactly when the default
+ *              parser throws
+ *   lazy       the same damaged streams, with and without recovery: a lazy
+ *              parse expanded with expandAll() builds the same tree and
+ *              errors as a full parse, or both throw
+ *   parallel   sources with a few short stretches of text cut out, with and
+ *              without recovery: compileClassParallel() on four threads
+ *              builds the same tree and errors as compileClass(), or both throw
+ *   query      trees of damaged streams parsed in recovery mode: TreeQuery
+ *              finds the same nodes as trying every node against every
+ *              chain of its ancestors, for a set of patterns, and the
+ *              documented doStatement/expression/term[draw] finds each call
+ *   binary     the same damaged streams: a tree written by
+ *              TreeWriter::writeBinary() and read back by MappedTree has the
+ *              shape of the tree written; copies with a child listed before
+ *              its parent or a byte missing are rejected with runtime_error,
+ *              and copies with a random byte changed are loaded or rejected,
+ *              never read out of bounds (run under ASan to see that)
+ *   incremental
+ *              random edits to the source, most inside one subroutine:
+ *              after each, IncrementalParser has the same tree as a full
+ *              parse of the edited source, its span() of every node is the
+ *              span of the matching node there, and it throws exactly when
+ *              the full parse does
+ *   cache      the damaged sources of the parallel check, parsed in recovery
+ *              mode, in a ParseCache in a new temporary directory: a source
+ *              misses until its tree is stored, then hits with the same
+ *              shape; the key changes when the source does; a truncated
+ *              entry misses and is deleted; evict() keeps the directory
+ *              within its limit
+ *   vm         a small class compiles with CodeGenerator to the VM code
+ *              written out by hand; on the damaged streams of the recovery
+ *              check, the CodeGenerator parse reports the same grammar
+ *              errors as the tree-building one
+ *   shared     the damaged streams of the recovery check: HashConsSink
+ *              builds a tree of the same shape, with the same errors, as
+ *              TreeSink, and two of its subtrees are equal only if they are
+ *              the same node
+ *   spans      the damaged sources of the parallel check: the span of every
+ *              token spells the token in the source, and LineIndex gives
+ *              each token's start and end the line and column found by
+ *              counting, and the end of the file for Span::UNKNOWN
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "JackGenerator.h"
+#include "../CodeGenerator.h"
+#include "../CompilerParser.h"
+#include "../FlatTree.h"
+#include "../HashConsSink.h"
+#include "../IncrementalParser.h"
+#include "../LineIndex.h"
+#include "../MappedFile.h"
+#include "../MappedTree.h"
+#include "../OutputBuffer.h"
+#include "../ParseCache.h"
+#include "../SymbolTable.h"
+#include "../ThreadPool.h"
+#include "../Tokenizer.h"
+#include "../TreeQuery.h"
+#include "../TreeWriter.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * What one check found
+ */
+struct Outcome {
+    uint64_t inputs = 0;
+    uint64_t errors = 0; // parse errors reported, so a check that never sees one is noticed
+    string failure;      // empty if every input agreed
+};
+
+/**
+ * A check, run on the source with the given seed for its damage
+ */
+struct Check {
+    const char* name;
+    function<Outcome(const string& source, uint32_t seed, int iterations)> run;
+};
+
+/**
+ * Get the shape of a tree: the kind, value and subtree end of every node in
+ * pre-order. Two trees are the same exactly when their shapes are.
+ */
+string shape(const ParseTree* root) {
+    FlatTree tree(root);
+    string text;
+    for (NodeId node = 0; node < tree.size(); node++) {
+        text += to_string((int) tree.kind(node)) + ":" + to_string(tree.value(node)) + ":"
+                + to_string(tree.end(node)) + ",";
+    }
+    return text;
+}
+
+/**
+ * Get where each error is and what was expected there, in the order reported
+ */
+string errorList(const vector<ParseError>& errors) {
+    string text;
+    for (const ParseError& error : errors) {
+        text += to_string(error.token) + ":" + to_string((int) error.expectedKind) + ":"
+                + to_string(error.expected) + ",";
+    }
+    return text;
+}
+
+/**
+ * Copy a token stream, dropping about one token in 40 and repeating a
+ * random token after about one in 40
+ */
+TokenBuffer damage(const TokenBuffer& tokens, mt19937& random) {
+    TokenBuffer damaged;
+    damaged.reserve(tokens.size() + tokens.size() / 20);
+    for (size_t i = 0; i < tokens.size(); i++) {
+        uint32_t roll = random() % 40;
+        if (roll == 0) {
+            continue;
+        }
+        damaged.push(tokens[i]);
+        if (roll == 1) {
+            damaged.push(tokens[random() % tokens.size()]);
+        }
+    }
+    return damaged;
+}
+
+/**
+ * The recovery check, see the top of the file
+ */
+Outcome checkRecovery(const string& source, uint32_t seed, int iterations) {
+    Outcome outcome;
+    TokenBuffer original = Tokenizer(source).tokenize();
+    mt19937 random(seed);
+
+    for (int i = 0; i < iterations; i++) {
+        TokenBuffer tokens = damage(original, random);
+        outcome.inputs++;
+
+        string shapes[2];
+        string errors[2];
+        size_t errorCount = 0;
+        for (int explicitStack = 0; explicitStack < 2; explicitStack++) {
+            CompilerParser parser(tokens);
+            parser.setRecovery(true);
+            if (explicitStack) {
+                parser.setMode(ParseMode::ExplicitStack);
+            }
+            ParseResult tree = parser.release(parser.compileClass());
+            shapes[explicitStack] = shape(tree.getRoot());
+            errors[explicitStack] = errorList(parser.getErrors());
+            errorCount = parser.getErrors().size();
+        }
+        if (shapes[0] != shapes[1] || errors[0] != errors[1]) {
+            outcome.failure = "input " + to_string(i) + ": the explicit stack parse differs from the recursive one";
+            return outcome;
+        }
+        outcome.errors += errorCount;
+
+        bool threw = false;
+        try {
+            CompilerParser parser(tokens);
+            parser.compileClass();
+        } catch (ParseException& e) {
+            threw = true;
+        }
+        if (threw != (errorCount != 0)) {
+            outcome.failure = "input " + to_string(i) + (threw ? ": the parser threw but recovery found no error"
+                                                               : ": recovery found errors but the parser did not throw");
+            return outcome;
+        }
+    }
+    return outcome;
+}
+
+/**
+ * Copy a source, cutting up to 7 bytes out of it in three random places
+ */
+string damage(const string& source, mt19937& random) {
+    string damaged = source;
+    for (int cut = 0; cut < 3; cut++) {
+        size_t position = random() % damaged.size();
+        damaged.erase(position, random() % 8);
+    }
+    return damaged;
+}
+
+/**
+ * Parse a class one way and describe the result
+ * @param compile Parses the class with the parser it is given
+ * @return The tree's shape and errors, or "throws" if the parser threw
+ */
+string parseClass(const TokenBuffer& tokens, bool recovering, const function<ParseTree*(CompilerParser&)>& compile) {
+    CompilerParser parser(tokens);
+    parser.setRecovery(recovering);
+    try {
+        ParseResult tree = parser.release(compile(parser));
+        return shape(tree.getRoot()) + "/" + errorList(parser.getErrors());
+    } catch (ParseException& e) {
+        return "throws";
+    }
+}
+
+/**
+ * Count the errors in a result of parseClass()
+ */
+uint64_t errorCount(const string& result) {
+    size_t errors = result.find('/');
+    return errors == string::npos ? 0 : count(result.begin() + errors, result.end(), ',');
+}
+
+ParseTree* compileClass(CompilerParser& parser) {
+    return parser.compileClass();
+}
+
+/**
+ * The lazy check, see the top of the file
+ */
+Outcome checkLazy(const string& source, uint32_t seed, int iterations) {
+    Outcome outcome;
+    TokenBuffer original = Tokenizer(source).tokenize();
+    mt19937 random(seed);
+
+    // a body missing its closing brace, which brace matching alone would end at the class's
+    TokenBuffer unclosed = Tokenizer("class A { function void g() { do f(); "
+                                     "function void h() { return; } }").tokenize();
+
+    for (int i = 0; i <= iterations; i++) {
+        TokenBuffer tokens = i == 0 ? move(unclosed) : damage(original, random);
+        outcome.inputs++;
+        for (int recovering = 0; recovering < 2; recovering++) {
+            string full = parseClass(tokens, recovering, compileClass);
+            string lazy = parseClass(tokens, recovering, [](CompilerParser& parser) {
+                parser.setLazy(true);
+                ParseTree* root = parser.compileClass();
+                parser.expandAll(root);
+                return root;
+            });
+            if (lazy != full) {
+                outcome.failure = "input " + to_string(i) + (recovering ? " in recovery mode" : "")
+                                  + ": the expanded lazy parse differs from the full one";
+                return outcome;
+            }
+            outcome.errors += errorCount(full);
+        }
+    }
+    return outcome;
+}
+
+/**
+ * The parallel check, see the top of the file
+ */
+Outcome checkParallel(const string& source, uint32_t seed, int iterations) {
+    Outcome outcome;
+    ThreadPool pool(4);
+    mt19937 random(seed);
+
+    for (int i = 0; i <= iterations; i++) {
+        TokenBuffer tokens;
+        try {
+            tokens = Tokenizer(i == 0 ? source : damage(source, random)).tokenize();
+        } catch (exception& e) {
+            continue; // a cut that leaves a string or comment open
+        }
+        outcome.inputs++;
+        for (int recovering = 0; recovering < 2; recovering++) {
+            string sequential = parseClass(tokens, recovering, compileClass);
+            string parallel = parseClass(tokens, recovering, [&pool](CompilerParser& parser) {
+                return parser.compileClassParallel(pool);
+            });
+            if (parallel != sequential) {
+                outcome.failure = "input " + to_string(i) + (recovering ? " in recovery mode" : "")
+                                  + ": the parallel parse differs from the sequential one";
+                return outcome;
+            }
+            outcome.errors += errorCount(sequential);
+        }
+    }
+    return outcome;
+}
+
+/**
+ * One step of a pattern, read independently of TreeQuery
+ */
+struct PatternStep {
+    bool descendant;
+    string kind; // "*" for any kind
+    string name; // empty if the step has none
+};
+
+/**
+ * Read a valid pattern into its steps
+ */
+vector<PatternStep> readPattern(const string& pattern) {
+    vector<PatternStep> steps;
+    size_t i = 0;
+    bool descendant = false;
+    while (true) {
+        PatternStep step{descendant, "", ""};
+        size_t start = i;
+        while (i < pattern.size() && pattern[i] != '/' && pattern[i] != '[') {
+            i++;
+        }
+        step.kind = pattern.substr(start, i - start);
+        if (i < pattern.size() && pattern[i] == '[') {
+            size_t close = pattern.find(']', i);
+            step.name = pattern.substr(i + 1, close - i - 1);
+            i = close + 1;
+        }
+        steps.push_back(step);
+        if (i == pattern.size()) {
+            return steps;
+        }
+        descendant = pattern.compare(i, 2, "//") == 0;
+        i += descendant ? 2 : 1;
+    }
+}
+
+/**
+ * Check a node against steps[step] and every chain of its ancestors against
+ * the steps before, the slow way
+ */
+bool bruteMatch(const FlatTree& tree, NodeId node, const vector<PatternStep>& steps, size_t step) {
+    const PatternStep& current = steps[step];
+    if (current.kind != "*" && kindName(tree.kind(node)) != current.kind) {
+        return false;
+    }
+    if (!current.name.empty() && Interner::global().str(tree.value(node)) != current.name) {
+        bool leafChild = false;
+        for (NodeId child : tree.children(node)) {
+            leafChild = leafChild || (tree.firstChild(child) == NO_NODE
+                                      && Interner::global().str(tree.value(child)) == current.name);
+        }
+        if (!leafChild) {
+            return false;
+        }
+    }
+    if (step == 0) {
+        return true;
+    }
+    for (NodeId ancestor = tree.parent(node); ancestor != NO_NODE; ancestor = tree.parent(ancestor)) {
+        if (bruteMatch(tree, ancestor, steps, step - 1)) {
+            return true;
+        }
+        if (!current.descendant) {
+            break;
+        }
+    }
+    return false;
+}
+
+/**
+ * The query check, see the top of the file
+ */
+Outcome checkQuery(const string& source, uint32_t seed, int iterations) {
+    const vector<string> patterns = {
+        "ifStatement//whileStatement", "whileStatement", "*", "term[x]", "*[x]",
+        "doStatement/expression/term[helper]", "doStatement//term[max]", "subroutine//term/expressionList",
+        "statements/*/statements", "*//ifStatement//*//term[a]", "expression/term//term", "class/*[f0]",
+        "letStatement//expression//expression//term", "error", "subroutine//*[Array]",
+    };
+    Outcome outcome;
+
+    // a name is on the leaves, so the call in a do statement is the term holding it
+    string calls = "class A { function void f() { do draw(1); do Screen.draw(x); do draw(draw(2)); return; } }";
+    CompilerParser parser(Tokenizer(calls).tokenize());
+    ParseResult callTree = parser.release(parser.compileClass());
+    FlatTree callFlat(callTree.getRoot());
+    TreeIndex callIndex(callFlat);
+    if (TreeQuery("doStatement/expression/term[draw]").find(callIndex).size() != 3
+        || TreeQuery("doStatement//term[draw]").find(callIndex).size() != 4) {
+        outcome.failure = "the calls of draw: the documented pattern does not find them";
+        return outcome;
+    }
+
+    TokenBuffer original = Tokenizer(source).tokenize();
+    mt19937 random(seed);
+    for (int i = 0; i < iterations; i++) {
+        TokenBuffer tokens = damage(original, random);
+        CompilerParser parser(tokens);
+        parser.setRecovery(true);
+        ParseResult tree = parser.release(parser.compileClass());
+        outcome.inputs++;
+        outcome.errors += parser.getErrors().size();
+
+        FlatTree flat(tree.getRoot());
+        TreeIndex index(flat);
+        for (const string& pattern : patterns) {
+            vector<PatternStep> steps = readPattern(pattern);
+            vector<NodeId> expected;
+            for (NodeId node = 0; node < flat.size(); node++) {
+                if (bruteMatch(flat, node, steps, steps.size() - 1)) {
+                    expected.push_back(node);
+                }
+            }
+            if (TreeQuery(pattern).find(index) != expected) {
+                outcome.failure = "input " + to_string(i) + ": " + pattern + " finds different nodes";
+                return outcome;
+            }
+        }
+    }
+    return outcome;
+}
+
+/**
+ * Add the shape of one node and its subtree of a MappedTree, as shape() has them
+ */
+void shapeRows(const MappedTree& tree, uint32_t node, vector<string>& rows, vector<size_t>& ends) {
+    size_t row = rows.size();
+    rows.push_back(to_string((int) tree.kind(node)) + ":" + to_string(Interner::global().intern(tree.value(node))));
+    ends.push_back(0);
+    uint32_t firstChild = tree.firstChild(node);
+    for (uint32_t child = firstChild; child < firstChild + tree.childCount(node); child++) {
+        shapeRows(tree, child, rows, ends);
+    }
+    ends[row] = rows.size();
+}
+
+/**
+ * Get the shape of a tree read back from the binary format, which is in
+ * breadth-first order, in the pre-order shape() gives
+ */
+string shape(const MappedTree& tree) {
+    vector<string> rows;
+    vector<size_t> ends;
+    shapeRows(tree, 0, rows, ends);
+    string text;
+    for (size_t row = 0; row < rows.size(); row++) {
+        text += rows[row] + ":" + to_string(ends[row]) + ",";
+    }
+    return text;
+}
+
+/**
+ * Check that a damaged tree file is either loaded or rejected
+ * @return false if it was not rejected but must have been
+ */
+bool loads(const string& bytes) {
+    try {
+        MappedTree tree(bytes.data(), bytes.size());
+        return true;
+    } catch (runtime_error& e) {
+        return false;
+    }
+}
+
+/**
+ * The binary check, see the top of the file
+ */
+Outcome checkBinary(const string& source, uint32_t seed, int iterations) {
+    Outcome outcome;
+    TokenBuffer original = Tokenizer(source).tokenize();
+    mt19937 random(seed);
+
+    for (int i = 0; i < iterations; i++) {
+        TokenBuffer tokens = damage(original, random);
+        CompilerParser parser(tokens);
+        parser.setRecovery(true);
+        ParseResult tree = parser.release(parser.compileClass());
+        outcome.inputs++;
+        outcome.errors += parser.getErrors().size();
+
+        string bytes;
+        {
+            OutputBuffer out(bytes);
+            TreeWriter::writeBinary(FlatTree(tree.getRoot()), out);
+        }
+        if (shape(MappedTree(bytes.data(), bytes.size())) != shape(tree.getRoot())) {
+            outcome.failure = "input " + to_string(i) + ": the tree read back differs from the tree written";
+            return outcome;
+        }
+
+        // the root listing itself as its first child, and a file one byte short
+        string selfChild = bytes;
+        uint32_t root = 0;
+        memcpy(&selfChild[sizeof(BinaryFormat::Header) + offsetof(BinaryFormat::Node, firstChild)], &root, sizeof(root));
+        if (loads(selfChild) || loads(bytes.substr(0, bytes.size() - 1))) {
+            outcome.failure = "input " + to_string(i) + ": a damaged tree file was loaded";
+            return outcome;
+        }
+
+        string changed = bytes;
+        changed[random() % changed.size()] = (char) random();
+        loads(changed);
+    }
+    return outcome;
+}
+
+/**
+ * Parse a whole source as a class
+ * @return The tree, with no root if the source does not tokenize or parse
+ */
+ParseResult parseSource(const string& source, unique_ptr<TokenBuffer>& tokens) {
+    try {
+        tokens = make_unique<TokenBuffer>(Tokenizer(source).tokenize());
+        CompilerParser parser(*tokens);
+        return parser.release(parser.compileClass());
+    } catch (ParseException& e) {
+        return ParseResult();
+    }
+}
+
+/**
+ * Compare the spans IncrementalParser gives the nodes of its tree with the
+ * spans of the matching nodes of another tree of the same shape
+ * @return The pre-order position of the first node that differs, or -1
+ */
+int64_t spanMismatch(const IncrementalParser& parser, const ParseTree* expected) {
+    vector<pair<const ParseTree*, const ParseTree*>> stack{{parser.getRoot(), expected}};
+    int64_t position = 0;
+    while (!stack.empty()) {
+        auto [node, other] = stack.back();
+        stack.pop_back();
+        Span found = parser.span(node);
+        Span wanted = other->span();
+        if (found.offset != wanted.offset || found.length != wanted.length) {
+            return position;
+        }
+        position++;
+        ChildRange children = node->getChildren();
+        for (size_t i = children.size(); i > 0; i--) {
+            stack.push_back({children[i - 1], other->getChildren()[i - 1]});
+        }
+    }
+    return -1;
+}
+
+/**
+ * The incremental check, see the top of the file
+ */
+Outcome checkIncremental(const string& source, uint32_t seed, int iterations) {
+    Outcome outcome;
+    mt19937 random(seed);
+    unique_ptr<IncrementalParser> parser;
+    try {
+        parser = make_unique<IncrementalParser>(source);
+    } catch (ParseException& e) {
+        outcome.failure = "the source does not parse";
+        return outcome;
+    }
+    uint64_t reparsed = 0;
+
+    for (int i = 0; i < iterations; i++) {
+        // most edits are somewhere inside a subroutine, the rest anywhere
+        const string& text = parser->getSource();
+        size_t begin = 0;
+        size_t end = text.size();
+        vector<const ParseTree*> subroutines;
+        for (const ParseTree* child : parser->getRoot()->getChildren()) {
+            if (child->getKind() == NodeKind::Subroutine) {
+                subroutines.push_back(child);
+            }
+        }
+        if (!subroutines.empty() && random() % 4 != 0) {
+            Span span = parser->span(subroutines[random() % subroutines.size()]);
+            begin = span.offset;
+            end = span.end();
+        }
+        size_t offset = begin + random() % (end - begin);
+
+        // insert blanks, a statement or a few bytes taken from elsewhere, or delete a few bytes
+        string inserted;
+        size_t length = 0;
+        switch (random() % 4) {
+            case 0: inserted = string(1 + random() % 3, random() % 2 == 0 ? ' ' : '\n'); break;
+            case 1: inserted = " let edited = edited + 1; "; break;
+            case 2: inserted = text.substr(random() % text.size(), 1 + random() % 4); break;
+            default: length = min(text.size() - offset, (size_t) (1 + random() % 3)); break;
+        }
+        string removed = text.substr(offset, length);
+
+        bool threw = false;
+        try {
+            reparsed += parser->edit(offset, length, inserted);
+        } catch (ParseException& e) {
+            threw = true;
+        }
+        outcome.inputs++;
+
+        unique_ptr<TokenBuffer> tokens;
+        ParseResult expected = parseSource(parser->getSource(), tokens);
+        if (threw != (expected.getRoot() == nullptr)) {
+            outcome.failure = "edit " + to_string(i) + (threw ? ": threw but the full parse did not"
+                                                             : ": did not throw but the full parse did");
+            return outcome;
+        }
+        if (threw) {
+            // undo it, so the next edit starts from a source that parses
+            outcome.errors++;
+            try {
+                parser->edit(offset, inserted.size(), removed);
+            } catch (ParseException& e) {
+                outcome.failure = "edit " + to_string(i) + ": undoing it did not parse";
+                return outcome;
+            }
+            continue;
+        }
+        if (shape(parser->getRoot()) != shape(expected.getRoot())) {
+            outcome.failure = "edit " + to_string(i) + ": the tree differs from a full parse";
+            return outcome;
+        }
+        int64_t mismatch = spanMismatch(*parser, expected.getRoot());
+        if (mismatch >= 0) {
+            outcome.failure = "edit " + to_string(i) + ": the span of node " + to_string(mismatch)
+                              + " differs from a full parse";
+            return outcome;
+        }
+    }
+    if (reparsed == 0) {
+        outcome.failure = "no edit was handled by reparsing one subroutine";
+    }
+    return outcome;
+}
+
+/**
+ * Add up the sizes of the entries in a cache directory
+ */
+uint64_t entryBytes(const fs::path& directory) {
+    uint64_t total = 0;
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory)) {
+        if (entry.path().extension() == ".jkt") {
+            total += entry.file_size();
+        }
+    }
+    return total;
+}
+
+/**
+ * The cache check, see the top of the file
+ */
+Outcome checkCache(const string& source, uint32_t seed, int iterations) {
+    Outcome outcome;
+    mt19937 random(seed);
+    const uint64_t maxBytes = 1 << 20;
+    fs::path directory = fs::temp_directory_path() / ("jack-check-" + to_string(seed) + "-" + to_string(random_device()()));
+    ParseCache cache(directory.string(), maxBytes);
+
+    for (int i = 0; i < iterations && outcome.failure.empty(); i++) {
+        string text = damage(source, random);
+        TokenBuffer tokens;
+        try {
+            tokens = Tokenizer(text).tokenize();
+        } catch (ParseException& e) {
+            continue;
+        }
+        CompilerParser parser(tokens);
+        parser.setRecovery(true);
+        ParseResult tree = parser.release(parser.compileClass());
+        outcome.inputs++;
+        outcome.errors += parser.getErrors().size();
+        string expected = shape(tree.getRoot());
+
+        // the same text may have been made and stored before, and then it must hit
+        string key = ParseCache::key(text);
+        unique_ptr<MappedTree> before = cache.load(key);
+        if (before != nullptr && shape(*before) != expected) {
+            outcome.failure = "input " + to_string(i) + ": an entry stored earlier has the wrong tree";
+        }
+        else if (!cache.store(key, FlatTree(tree.getRoot()))) {
+            outcome.failure = "input " + to_string(i) + ": the tree was not stored";
+        }
+        else {
+            unique_ptr<MappedTree> hit = cache.load(key);
+            if (hit == nullptr || shape(*hit) != expected) {
+                outcome.failure = "input " + to_string(i) + ": the stored tree was not loaded back";
+            }
+            else if (ParseCache::key(text + "\n") == key || cache.load(ParseCache::key(text + "\n")) != nullptr) {
+                outcome.failure = "input " + to_string(i) + ": an edited source hit the entry of the original";
+            }
+        }
+
+        // every so often, cut an entry short behind the cache's back
+        fs::path entry = directory / (key + ".jkt");
+        if (outcome.failure.empty() && i % 8 == 0) {
+            fs::resize_file(entry, fs::file_size(entry) / 2);
+            if (cache.load(key) != nullptr || fs::exists(entry)) {
+                outcome.failure = "input " + to_string(i) + ": a truncated entry was loaded or kept";
+            }
+        }
+
+        cache.evict();
+        if (outcome.failure.empty() && entryBytes(directory) > maxBytes) {
+            outcome.failure = "input " + to_string(i) + ": evict() left the directory over its limit";
+        }
+    }
+
+    error_code error;
+    fs::remove_all(directory, error);
+    return outcome;
+}
+
+/**
+ * Compile a token stream to VM code in recovery mode
+ * @param errors Set to the grammar errors reported
+ * @return The code
+ */
+string compileVm(const TokenBuffer& tokens, vector<ParseError>& errors) {
+    string code;
+    {
+        OutputBuffer out(code);
+        SymbolTable symbols;
+        BasicParser<CodeGenerator> parser(tokens, CodeGenerator(out, symbols));
+        parser.setRecovery(true);
+        parser.setSymbols(&symbols);
+        parser.compileClass();
+        errors = parser.getErrors();
+    }
+    return code;
+}
+
+/**
+ * The vm check, see the top of the file
+ */
+Outcome checkVm(const string& source, uint32_t seed, int iterations) {
+    Outcome outcome;
+    const string known =
+        "class Main { field int x; method int get(int a) { var int b; let b = x + a; "
+        "if (b > 1) { return b; } else { return -b; } } "
+        "function void main() { do Output.printInt(2 * 3); return; } }";
+    const string expected =
+        "function Main.get 1\n"
+        "push argument 0\npop pointer 0\n"
+        "push this 0\npush argument 1\nadd\npop local 0\n"
+        "push local 0\npush constant 1\ngt\nnot\nif-goto IF_FALSE0\n"
+        "push local 0\nreturn\n"
+        "goto IF_END0\nlabel IF_FALSE0\n"
+        "push local 0\nneg\nreturn\n"
+        "label IF_END0\n"
+        "function Main.main 0\n"
+        "push constant 2\npush constant 3\ncall Math.multiply 2\n"
+        "call Output.printInt 1\npop temp 0\n"
+        "push constant 0\nreturn\n";
+
+    vector<ParseError> errors;
+    outcome.inputs++;
+    if (compileVm(Tokenizer(known).tokenize(), errors) != expected || !errors.empty()) {
+        outcome.failure = "input 0: the known class compiled to different code";
+        return outcome;
+    }
+
+    TokenBuffer original = Tokenizer(source).tokenize();
+    mt19937 random(seed);
+    for (int i = 1; i < iterations; i++) {
+        TokenBuffer tokens = damage(original, random);
+        compileVm(tokens, errors);
+        outcome.inputs++;
+        outcome.errors += errors.size();
+
+        CompilerParser parser(tokens);
+        parser.setRecovery(true);
+        ParseResult tree = parser.release(parser.compileClass());
+        if (errorList(errors) != errorList(parser.getErrors())) {
+            outcome.failure = "input " + to_string(i) + ": the errors differ from a tree-building parse";
+            return outcome;
+        }
+    }
+    return outcome;
+}
+
+/**
+ * Number the distinct subtrees of a tree by structure, and find a subtree
+ * that is made twice
+ * @param node The subtree to number
+ * @param numbers The number of each node already seen
+ * @param nodes The node with each structure seen so far, and its number
+ * @return false if a subtree equal to this one, or one inside it, is another node
+ */
+bool numberShared(const ParseTree* node, map<const ParseTree*, uint32_t>& numbers,
+                  map<vector<uint32_t>, pair<uint32_t, const ParseTree*>>& nodes) {
+    if (numbers.count(node) != 0) {
+        return true;
+    }
+    vector<uint32_t> structure{(uint32_t) node->getKind(), node->getAtom(), node->isToken()};
+    for (const ParseTree* child : node->getChildren()) {
+        if (!numberShared(child, numbers, nodes)) {
+            return false;
+        }
+        structure.push_back(numbers[child]);
+    }
+    auto found = nodes.emplace(structure, make_pair((uint32_t) nodes.size(), node)).first;
+    numbers[node] = found->second.first;
+    return found->second.second == node;
+}
+
+/**
+ * The shared check, see the top of the file
+ */
+Outcome checkShared(const string& source, uint32_t seed, int iterations) {
+    Outcome outcome;
+    TokenBuffer original = Tokenizer(source).tokenize();
+    mt19937 random(seed);
+
+    for (int i = 0; i < iterations; i++) {
+        TokenBuffer tokens = damage(original, random);
+        CompilerParser parser(tokens);
+        parser.setRecovery(true);
+        ParseResult tree = parser.release(parser.compileClass());
+        outcome.inputs++;
+        outcome.errors += parser.getErrors().size();
+
+        BasicParser<HashConsSink> sharing(tokens);
+        sharing.setRecovery(true);
+        ParseResult shared = sharing.sink.release(sharing.compileClass());
+        if (shape(shared.getRoot()) != shape(tree.getRoot())
+            || errorList(sharing.getErrors()) != errorList(parser.getErrors())) {
+            outcome.failure = "input " + to_string(i) + ": the shared tree or its errors differ from TreeSink's";
+            return outcome;
+        }
+
+        map<const ParseTree*, uint32_t> numbers;
+        map<vector<uint32_t>, pair<uint32_t, const ParseTree*>> nodes;
+        if (!numberShared(shared.getRoot(), numbers, nodes)) {
+            outcome.failure = "input " + to_string(i) + ": two equal subtrees are different nodes";
+            return outcome;
+        }
+    }
+    return outcome;
+}
+
+/**
+ * The spans check, see the top of the file
+ */
+Outcome checkSpans(const string& source, uint32_t seed, int iterations) {
+    Outcome outcome;
+    mt19937 random(seed);
+
+    for (int i = 0; i < iterations; i++) {
+        string text = i == 0 ? source : damage(source, random);
+        TokenBuffer tokens;
+        try {
+            tokens = Tokenizer(text).tokenize();
+        } catch (ParseException& e) {
+            continue;
+        }
+        outcome.inputs++;
+
+        // the line and column of every offset, and one past the end, by counting
+        vector<Location> expected;
+        expected.reserve(text.size() + 1);
+        Location location{1, 1};
+        for (char c : text) {
+            expected.push_back(location);
+            location = c == '\n' ? Location{location.line + 1, 1} : Location{location.line, location.column + 1};
+        }
+        expected.push_back(location);
+
+        LineIndex lines(text);
+        auto locates = [&](uint32_t offset, size_t position) {
+            Location found = lines.locate(offset);
+            return found.line == expected[position].line && found.column == expected[position].column;
+        };
+        if (!locates(Span::UNKNOWN, text.size())) {
+            outcome.failure = "input " + to_string(i) + ": an unknown offset is not the end of the file";
+            return outcome;
+        }
+
+        for (size_t t = 0; t < tokens.size(); t++) {
+            Span span = tokens[t]->getSpan();
+            if (!span.known()) {
+                continue; // the Eof token
+            }
+            string spelling = tokens[t]->getValue();
+            if (tokens[t]->getKind() == NodeKind::StringConstant) {
+                spelling = "\"" + spelling + "\"";
+            }
+            if (span.end() > text.size() || text.compare(span.offset, span.length, spelling) != 0) {
+                outcome.failure = "input " + to_string(i) + ": the span of token " + to_string(t) + " does not spell it";
+                return outcome;
+            }
+            if (!locates(span.offset, span.offset) || !locates(span.end(), span.end())) {
+                outcome.failure = "input " + to_string(i) + ": LineIndex misplaces token " + to_string(t);
+                return outcome;
+            }
+        }
+    }
+    return outcome;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorOptions options;
+    options.bytes = 1 << 14;
+    int iterations = 2000;
+    string corpus;
+    vector<string> names;
+
+    for (int i = 1; i < argc; i++) {
+        string flag = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (flag == "--bytes" && hasValue) {
+            options.bytes = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (flag == "--seed" && hasValue) {
+            options.seed = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if (flag == "--iterations" && hasValue) {
+            iterations = max(1, atoi(argv[++i]));
+        }
+        else if (flag == "--corpus" && hasValue) {
+            corpus = argv[++i];
+        }
+        else if (flag.rfind("--", 0) == 0) {
+            cerr << "unknown option " << flag << endl;
+            return 1;
+        }
+        else {
+            names.push_back(flag);
+        }
+    }
+
+    const vector<Check> checks = {
+        {"recovery", checkRecovery},
+        {"lazy", checkLazy},
+        {"parallel", checkParallel},
+        {"query", checkQuery},
+        {"binary", checkBinary},
+        {"incremental", checkIncremental},
+        {"cache", checkCache},
+        {"vm", checkVm},
+        {"shared", checkShared},
+        {"spans", checkSpans},
+    };
+
+    string source;
+    try {
+        if (!corpus.empty()) {
+            MappedFile file(corpus);
+            source = string(file.text());
+        }
+        else {
+            source = JackGenerator(options).generate(Production::Class);
+        }
+    } catch (exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    bool failed = false;
+    for (const string& name : names) {
+        bool known = false;
+        for (const Check& check : checks) {
+            known = known || name == check.name;
+        }
+        if (!known) {
+            cerr << "unknown check " << name << endl;
+            return 1;
+        }
+    }
+    for (const Check& check : checks) {
+        if (!names.empty() && find(names.begin(), names.end(), check.name) == names.end()) {
+            continue;
+        }
+        Outcome outcome = check.run(source, options.seed, iterations);
+        if (outcome.failure.empty()) {
+            printf("%-12s ok, %llu inputs, %llu errors\n", check.name,
+                   (unsigned long long) outcome.inputs, (unsigned long long) outcome.errors);
+        }
+        else {
+            printf("%-12s FAILED at %s\n", check.name, outcome.failure.c_str());
+            failed = true;
+        }
+    }
+    return failed ? 1 : 0;
+}
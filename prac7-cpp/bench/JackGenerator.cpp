@@ -0,0 +1,257 @@
+#include "JackGenerator.h"
+
+using namespace std;
+
+namespace {
+
+const char* const VARIABLES[] = {"a", "b", "count", "total", "index", "value", "x", "y"};
+const char* const OPERATORS[] = {" + ", " - ", " * ", " / ", " & ", " | ", " < ", " > ", " = "};
+const char* const CALLS[] = {"Math.max", "Math.min", "Memory.peek", "Output.printInt", "helper", "list.get"};
+
+// each subroutine body is about this large, so a class is many subroutines
+const uint64_t SUBROUTINE_BYTES = 2048;
+
+}
+
+/**
+ * Constructor for a JackGenerator
+ * @param options The size and shape of the source to generate
+ */
+JackGenerator::JackGenerator(const GeneratorOptions& options) {
+    this->options = options;
+    this->out = nullptr;
+    this->written = 0;
+    this->state = options.seed * 0x9E3779B97F4A7C15ull + 1;
+    this->subroutines = 0;
+}
+
+/**
+ * A pseudo-random number, the same on every platform for the same seed
+ * @param bound One more than the largest number wanted
+ * @return A number in [0, bound)
+ */
+uint32_t JackGenerator::random(uint32_t bound) {
+    // xorshift64*
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (uint32_t) (((state * 0x2545F4914F6CDD1Dull) >> 32) % bound);
+}
+
+bool JackGenerator::chance(double probability) {
+    return random(1 << 20) < probability * (1 << 20);
+}
+
+void JackGenerator::emit(string_view text) {
+    out->write(text);
+    written += text.size();
+}
+
+/**
+ * Write Jack source until the size in the options is reached
+ * @param out Where to write
+ * @param production What to write: a class, or the input of a narrower compile method
+ * @return The number of bytes written
+ */
+uint64_t JackGenerator::write(OutputBuffer& out, Production production) {
+    this->out = &out;
+    written = 0;
+
+    switch (production) {
+        case Production::Class:
+            emit("class Generated {\n");
+            emit("    field int size, capacity;\n");
+            emit("    static Array table;\n\n");
+            while (written < options.bytes) {
+                writeSubroutine(SUBROUTINE_BYTES);
+            }
+            emit("}\n");
+            break;
+
+        case Production::Subroutine:
+            writeSubroutine(options.bytes);
+            break;
+
+        case Production::Statements:
+            while (written < options.bytes) {
+                writeStatement(options.depth, 0);
+            }
+            break;
+
+        case Production::Expression:
+            writeTerm(options.depth);
+            while (written < options.bytes) {
+                emit(OPERATORS[random(9)]);
+                writeTerm(options.depth);
+            }
+            emit("\n");
+            break;
+    }
+
+    out.flush();
+    return written;
+}
+
+/**
+ * Generate Jack source into a string
+ * @param production What to write: a class, or the input of a narrower compile method
+ * @return The source
+ */
+string JackGenerator::generate(Production production) {
+    string text;
+    {
+        OutputBuffer buffer(text);
+        write(buffer, production);
+    }
+    return text;
+}
+
+/**
+ * Write one subroutine whose body is about bodyBytes long
+ */
+void JackGenerator::writeSubroutine(uint64_t bodyBytes) {
+    static const char* const KINDS[] = {"function", "method", "constructor"};
+    static const char* const TYPES[] = {"int", "boolean", "void", "char", "Array"};
+
+    emit("    ");
+    emit(KINDS[random(3)]);
+    emit(" ");
+    emit(TYPES[random(5)]);
+    emit(" f");
+    emit(to_string(subroutines++));
+    emit("(int a, boolean b, Array list) {\n");
+    emit("        var int count, total, index;\n");
+    emit("        var Array value;\n");
+
+    uint64_t end = written + bodyBytes;
+    while (written < end) {
+        writeStatement(options.depth, 2);
+    }
+    emit("        return total;\n");
+    emit("    }\n\n");
+}
+
+/**
+ * Write one statement, nesting if/while bodies at most depth deep
+ */
+void JackGenerator::writeStatement(int depth, int indent) {
+    string spaces(indent * 4, ' ');
+    emit(spaces);
+
+    uint32_t kind = random(depth > 0 ? 10 : 6);
+    if (kind < 3) {
+        emit("let ");
+        emit(VARIABLES[random(8)]);
+        if (kind == 2) {
+            emit("[");
+            writeExpression(options.depth);
+            emit("]");
+        }
+        emit(" = ");
+        writeExpression(options.depth);
+        emit(";\n");
+    }
+    else if (kind < 5) {
+        emit("do ");
+        emit(CALLS[random(6)]);
+        emit("(");
+        writeExpression(options.depth);
+        emit(", ");
+        writeExpression(options.depth);
+        emit(");\n");
+    }
+    else if (kind < 6) {
+        emit("return ");
+        writeExpression(options.depth);
+        emit(";\n");
+    }
+    else {
+        bool isIf = kind < 8;
+        emit(isIf ? "if (" : "while (");
+        writeExpression(options.depth);
+        emit(") {\n");
+
+        int statements = 1 + (int) random(3);
+        for (int i = 0; i < statements; i++) {
+            writeStatement(depth - 1, indent + 1);
+        }
+        emit(spaces);
+        emit("}");
+
+        if (isIf && chance(0.5)) {
+            emit(" else {\n");
+            writeStatement(depth - 1, indent + 1);
+            emit(spaces);
+            emit("}");
+        }
+        emit("\n");
+    }
+}
+
+/**
+ * Write term (op term)*, longer the denser expressions are
+ */
+void JackGenerator::writeExpression(int depth) {
+    writeTerm(depth);
+    while (chance(options.expressionDensity)) {
+        emit(OPERATORS[random(9)]);
+        writeTerm(depth);
+    }
+}
+
+/**
+ * Write one term, nesting at most depth deep
+ */
+void JackGenerator::writeTerm(int depth) {
+    static const char* const CONSTANTS[] = {"true", "false", "null", "this"};
+
+    // nesting half as often as expressions grow keeps their expected size finite
+    if (depth > 0 && chance(options.expressionDensity / 2)) {
+        switch (random(5)) {
+            case 0:
+                emit("(");
+                writeExpression(depth - 1);
+                emit(")");
+                return;
+            case 1:
+                emit(VARIABLES[random(8)]);
+                emit("[");
+                writeExpression(depth - 1);
+                emit("]");
+                return;
+            case 2:
+                emit(CALLS[random(6)]);
+                emit("(");
+                writeExpression(depth - 1);
+                emit(", ");
+                writeExpression(depth - 1);
+                emit(")");
+                return;
+            case 3:
+                emit("-");
+                writeTerm(depth - 1);
+                return;
+            default:
+                emit("~");
+                writeTerm(depth - 1);
+                return;
+        }
+    }
+
+    switch (random(5)) {
+        case 0:
+            emit(to_string(random(32768)));
+            return;
+        case 1:
+            emit("\"text ");
+            emit(to_string(random(100)));
+            emit("\"");
+            return;
+        case 2:
+            emit(CONSTANTS[random(4)]);
+            return;
+        default:
+            emit(VARIABLES[random(8)]);
+            return;
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef JACKGENERATOR_H
+#define JACKGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "../OutputBuffer.h"
+
+/**
+ * What a JackGenerator produces: a whole class, or the input of one of the
+ * narrower compile methods
+ */
+enum class Production {
+    Class,
+    Subroutine,
+    Statements,
+    Expression
+};
+
+/**
+ * The shape of the generated source
+ */
+struct GeneratorOptions {
+    // stop once about this many bytes have been written
+    uint64_t bytes = 1 << 20;
+
+    // deepest nesting of if/while bodies, and of ( ), [ ] and calls in expressions
+    int depth = 4;
+
+    // from 0 to 1: how long expressions are, and how often terms nest
+    double expressionDensity = 0.3;
+
+    uint32_t seed = 1;
+};
+
+/**
+ * Writes random but valid Jack source for the grammar CompilerParser accepts,
+ * for benchmarking. The same options always produce the same text, and the
+ * text is streamed to an OutputBuffer, so the size is only limited by the disk.
+ */
+class JackGenerator {
+    private:
+        GeneratorOptions options;
+        OutputBuffer* out;
+        uint64_t written;
+        uint64_t state;
+        int subroutines;
+
+        uint32_t random(uint32_t bound);
+        bool chance(double probability);
+        void emit(std::string_view text);
+
+        void writeSubroutine(uint64_t bodyBytes);
+        void writeStatement(int depth, int indent);
+        void writeExpression(int depth);
+        void writeTerm(int depth);
+
+    public:
+        JackGenerator(const GeneratorOptions& options);
+
+        uint64_t write(OutputBuffer& out, Production production = Production::Class);
+
+        std::string generate(Production production = Production::Class);
+};
+
+#endif /*JACKGENERATOR_H*/